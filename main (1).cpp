@@ -2,205 +2,644 @@
  * Programa demostrativo de manipulación y procesamiento de imágenes BMP en C++ usando Qt.
  *
  * Descripción:
- * Este programa realiza las siguientes tareas:
- * 1. Carga una imagen BMP desde un archivo (formato RGB sin usar estructuras ni STL).
- * 2. Modifica los valores RGB de los píxeles asignando un degradado artificial basado en su posición.
- * 3. Exporta la imagen modificada a un nuevo archivo BMP.
- * 4. Carga un archivo de texto que contiene una semilla (offset) y los resultados del enmascaramiento
- *    aplicados a una versión transformada de la imagen, en forma de tripletas RGB.
- * 5. Muestra en consola los valores cargados desde el archivo de enmascaramiento.
- * 6. Gestiona la memoria dinámicamente, liberando los recursos utilizados.
- *
- * Entradas:
- * - Archivo de imagen BMP de entrada ("I_O.bmp").
- * - Archivo de salida para guardar la imagen modificada ("I_D.bmp").
- * - Archivo de texto ("M1.txt") que contiene:
- *     • Una línea con la semilla inicial (offset).
- *     • Varias líneas con tripletas RGB resultantes del enmascaramiento.
- *
- * Salidas:
- * - Imagen BMP modificada ("I_D.bmp").
- * - Datos RGB leídos desde el archivo de enmascaramiento impresos por consola.
+ * Sin opciones, el programa realiza las siguientes tareas:
+ * 1. Carga M1.txt (semilla y tripletas RGB del enmascaramiento) y muestra sus valores por consola,
+ *    antes de que el proceso lo vuelva a generar.
+ * 2. Arma un grafo perezoso de etapas sobre I_O.bmp, I_M.bmp y M.bmp:
+ *      P1 = I_O ^ I_M,  P2 = ror(P1, 3),  P3 = rol(P2, 3) ^ I_M
+ *    Nada se calcula hasta que un sumidero o una consulta lo necesita.
+ * 3. Escribe en segundo plano los archivos de enmascaramiento M2.txt (de P1) y M1.txt (de P2) y,
+ *    mientras tanto, comprueba en memoria que P3 sea igual a I_O; si no lo es, muestra dónde y
+ *    cuánto difieren.
+ * 4. Exporta I_D.bmp, una imagen del tamaño de I_O con un degradado artificial.
+ * 5. Compara M1.txt y M2.txt byte a byte con M1_generado.txt y M2_generado.txt.
+ * 6. Infiere, a partir de P2, I_M, M y M2, la transformación inversa del último paso y verifica que
+ *    reconstruye P1.
+ *
+ * Opciones del proceso por defecto:
+ * - "--intermedios": escribe también P1.bmp, P2.bmp y P3.bmp. Sin ella solo existen en memoria.
+ * - "--binario": escribe además M1.msk y M2.msk (enmascaramiento en binario), y la inferencia lee
+ *   M2.msk en lugar de M2.txt.
+ *
+ * Otros modos (cada uno reemplaza al proceso por defecto):
+ * - "--franjas N": genera P2.bmp leyendo y escribiendo de a N filas, sin cargar las imágenes
+ *   completas en memoria.
+ * - "--comparar A.bmp B.bmp": compara dos imágenes y, si difieren, muestra el informe de diferencias.
+ * - "--a-binario M.txt M.msk" y "--a-texto M.msk M.txt": convierten un archivo de enmascaramiento
+ *   de un formato al otro.
+ * - "--bench-kernels [MiB]": microbenchmark de los kernels de píxeles (hasta 128 MiB por defecto).
+ * - "--bench-pipeline [VGA|HD|FHD|4K|8K|16K]": benchmark de punta a punta sobre imágenes sintéticas,
+ *   desde VGA hasta la resolución indicada (16K por defecto).
+ * - "--verificar-inferencia [N]": contrasta los kernels de la inferencia con una referencia escalar
+ *   por fuerza bruta en N ventanas aleatorias (10000 por defecto).
+ *
+ * En cualquier modo:
+ * - "--trace archivo.json": registra cada etapa y kernel y los vuelca al terminar.
+ * - "--paginas-grandes": pide páginas de 2 MiB para los buffers grandes.
+ *
+ * Diseño:
+ * - Las imágenes son valores Imagen que son dueños de su buffer o vistas de solo lectura (recortes,
+ *   franjas o buffers ajenos). Los buffers salen de un pool por clases de tamaño, y las imágenes
+ *   de entrada se cargan una sola vez en un registro compartido.
+ * - Los kernels de píxeles (XOR, rotaciones, tablas, enmascaramiento, comparación) tienen versiones
+ *   SIMD que se eligen al arrancar según la CPU, y se reparten entre los hilos de un pool fijo.
  *
  * Requiere:
  * - Librerías Qt para manejo de imágenes (QImage, QString).
- * - No utiliza estructuras ni STL. Solo arreglos dinámicos y memoria básica de C++.
+ * - C++17 y la biblioteca estándar (hilos, atómicos).
  *
  * Autores: Augusto Salazar y Aníbal Guerra
  * Fecha: 06/04/2025
  * Asistencia de ChatGPT para mejorar la forma y presentación del código fuente
  */
 
-#include <fstream>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
 #include <QCoreApplication>
 #include <QImage>
 
+// Intrínsecos SIMD: solo se compilan con GCC/Clang sobre x86. Cada variante se compila con su
+// propio atributo target y se elige en tiempo de ejecución según lo que reporte CPUID, de modo que
+// el ejecutable funciona en cualquier CPU x86-64 sin necesidad de flags globales como -mavx2.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define DESAFIO_X86 1
+#include <immintrin.h>
+#define OBJETIVO_CPU(isa) __attribute__((target(isa)))
+#endif
+
+// Proyección de archivos en memoria
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <malloc.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include <sys/stat.h>
+
 using namespace std;
 
-unsigned char* loadPixels(QString input, int &width, int &height);
-bool exportImage(unsigned char* pixelData, int width, int height, QString archivoSalida);
-unsigned int* loadSeedMasking(const char* nombreArchivo, int &seed, int &n_pixels);
-void applyXOR(unsigned char* img1, unsigned char* img2, unsigned char* result, int dataSize);
-void rotateBitsRight(unsigned char* data, int dataSize, int bits);
-void rotateBitsLeft(unsigned char* data, int dataSize, int bits);
-void generarM1DesdeP2(unsigned char* data, int offset, int n_pixels);
-void generarM2DesdeP1(unsigned char* p1, int offset, int n_pixels);
-bool compararImagenes(QString archivo1, QString archivo2);
-bool compararArchivos(const char* archivo1, const char* archivo2);
-
-int main()
-{
-    // Definición de rutas de archivo de entrada (imagen original) y salida (imagen modificada)
-    QString archivoEntrada = "I_O.bmp";
-    QString archivoSalida = "I_D.bmp";
-    QString archivoIM = "I_M.bmp";
+// Pool de hilos persistente. ejecutarEnParalelo reparte [0, total) en un rango contiguo por hilo
+// (múltiplos de granularidad, normalmente una línea de caché) y llama tarea(contexto, desde, hasta)
+// en cada uno; el hilo que llama procesa el primer rango y espera a los demás. Si total es menor que
+// minimo, o el pool está ocupado, la tarea se ejecuta entera en el hilo que llama.
+typedef void (*TareaRango)(void* contexto, size_t desde, size_t hasta);
 
-    // Variables para almacenar las dimensiones de la imagen
-    int width = 0;
-    int height = 0;
+const size_t TAMANO_LINEA_CACHE = 64;
+const size_t MIN_BYTES_PARALELO = 1 << 20;   // Por debajo, despertar hilos cuesta más que el trabajo
 
-    // Carga la imagen BMP en memoria dinámica y obtiene ancho y alto
-    unsigned char *pixelData = loadPixels(archivoEntrada, width, height);
+void ejecutarEnParalelo(TareaRango tarea, void* contexto, size_t total,
+                        size_t minimo = MIN_BYTES_PARALELO, size_t granularidad = TAMANO_LINEA_CACHE);
 
-    // Cargar la imagen de distorsión (IM)
-    int width2 = 0;
-    int height2 = 0;
-    unsigned char* imgM = loadPixels(archivoIM, width2, height2);
+// Trazas por etapa ("--trace archivo.json"). Un SpanTraza mide desde que se construye hasta que sale
+// de alcance y, si las trazas están activas, deja un evento con los bytes procesados en un buffer
+// circular propio del hilo (sin cerrojos). Con las trazas apagadas cuesta una lectura atómica.
+// activarTrazas registra el volcado del archivo, en formato Chrome trace-event (chrome://tracing,
+// Perfetto), para cuando termine el programa.
+extern atomic<bool> trazasActivas;
+unsigned long long relojTrazaNs();
+void registrarEventoTraza(const char* nombre, unsigned long long inicioNs, unsigned long long finNs, size_t bytes);
+void activarTrazas(const char* archivoSalida);
+bool escribirTrazas(const char* archivoSalida);
 
-    // Verifica que ambas imágenes tengan el mismo tamaño antes de aplicar XOR
-    if (pixelData && imgM && width == width2 && height == height2) {
-        int dataSize = width * height * 3;
+struct SpanTraza {
+    const char* nombre;            // Debe ser un literal: solo se guarda el puntero
+    size_t bytes;                  // Se puede completar después, cuando se conoce el tamaño
+    unsigned long long inicioNs;   // 0 si las trazas estaban apagadas al construirlo
 
-        // Reservar memoria para el resultado del XOR
-        unsigned char* resultadoXOR = new unsigned char[dataSize];
+    explicit SpanTraza(const char* nombre, size_t bytes = 0)
+        : nombre(nombre), bytes(bytes),
+          inicioNs(trazasActivas.load(memory_order_relaxed) ? relojTrazaNs() : 0) {}
+    ~SpanTraza() {
+        if (inicioNs != 0) registrarEventoTraza(nombre, inicioNs, relojTrazaNs(), bytes);
+    }
+};
 
-        // Aplicar operación XOR
-        applyXOR(pixelData, imgM, resultadoXOR, dataSize);
+// Buffers de píxeles reciclables. reservarBufferPixeles devuelve al menos `bytes` bytes alineados a
+// una línea de caché; liberarBufferPixeles los devuelve a un pool por clase de tamaño en lugar de al
+// sistema, así que la siguiente etapa o imagen del mismo tamaño reutiliza memoria ya tocada, sin
+// pedir páginas nuevas al kernel. Los bloques grandes se alinean a 2 MiB; después de
+// activarPaginasGrandes() además se marcan en Linux con madvise(MADV_HUGEPAGE), que por defecto no
+// se pide porque puede agregar latencia de compactación y memoria residente. Igual que new[], si no
+// hay memoria lanza std::bad_alloc. vaciarPoolBuffers devuelve al sistema todo lo que el pool tenga
+// guardado.
+unsigned char* reservarBufferPixeles(size_t bytes);
+void liberarBufferPixeles(unsigned char* buffer);
+void vaciarPoolBuffers();
+void activarPaginasGrandes();
 
-        exportImage(resultadoXOR, width, height, "P1.bmp");
+// Formatos de píxel de una Imagen. Todo el programa trabaja en RGB888 (R, G, B, un byte cada uno).
+enum FormatoImagen {
+    FORMATO_RGB888
+};
 
+int bytesPorPixelFormato(FormatoImagen formato);
 
-        // Aplicar rotación de 3 bits a la derecha a cada byte del resultado del XOR
-        rotateBitsRight(resultadoXOR, dataSize, 3);
+// Imagen en memoria. O es dueña de su buffer (del pool de buffers de píxeles, que devuelve al
+// destruirse) o es una vista de solo lectura de píxeles ajenos: un recorte o una franja de otra
+// imagen, o un buffer que pertenece a otro (por ejemplo, al registro de imágenes). Se escribe
+// únicamente a través de propio, que las vistas no tienen. Solo se mueve: copiarla tiene que ser
+// explícito con clonar(). Mover una imagen no mueve sus píxeles, así que las vistas siguen siendo
+// válidas mientras exista el dueño del buffer.
+struct Imagen {
+    const unsigned char* datos;    // Primer píxel de la fila 0 (nullptr si la imagen está vacía)
+    int width;
+    int height;
+    size_t paso;                   // Bytes entre el comienzo de una fila y el de la siguiente
+    FormatoImagen formato;
+    unsigned char* propio;         // El mismo buffer, escribible, si es dueña de él; nullptr en las vistas
 
-        // Exportar la imagen resultante del XOR
-        exportImage(resultadoXOR, width, height, "P2.bmp");
+    Imagen() : datos(nullptr), width(0), height(0), paso(0), formato(FORMATO_RGB888), propio(nullptr) {}
+    Imagen(int width, int height, FormatoImagen formato = FORMATO_RGB888);
+    Imagen(Imagen &&otra) noexcept;
+    Imagen &operator=(Imagen &&otra) noexcept;
+    Imagen(const Imagen &) = delete;
+    Imagen &operator=(const Imagen &) = delete;
+    ~Imagen() { liberarBufferPixeles(propio); }
 
-        // Liberar la memoria usada para el resultado del XOR
-        if (resultadoXOR != nullptr) {
-            delete[] resultadoXOR;
-            resultadoXOR = nullptr;
-        }
-    } else {
-        cout << "No se pudo aplicar XOR. Verifica que las imágenes tengan el mismo tamaño y estén bien cargadas." << endl;
-    }
+    // Toma un buffer de reservarBufferPixeles (por ejemplo, el de loadPixels) sin copiarlo
+    static Imagen adoptar(unsigned char* buffer, int width, int height, FormatoImagen formato = FORMATO_RGB888);
+    // Vista de solo lectura de píxeles ajenos; paso 0 significa filas contiguas
+    static Imagen vistaDe(const unsigned char* datos, int width, int height, size_t paso = 0,
+                          FormatoImagen formato = FORMATO_RGB888);
 
-    // Simula una modificación de la imagen asignando valores RGB incrementales
-    // (Esto es solo un ejemplo de manipulación artificial)
-    for (int i = 0; i < width * height * 3; i += 3) {
-        pixelData[i] = i;     // Canal rojo
-        pixelData[i + 1] = i; // Canal verde
-        pixelData[i + 2] = i; // Canal azul
-    }
+    bool vacia() const { return datos == nullptr; }
+    bool esVista() const { return datos != nullptr && propio == nullptr; }
+    int bytesPorPixel() const { return bytesPorPixelFormato(formato); }
+    bool continua() const { return paso == (size_t)width * bytesPorPixel(); }
+    size_t bytes() const { return (size_t)width * height * bytesPorPixel(); }   // Sin el relleno entre filas
+    const unsigned char* fila(int y) const { return datos + (size_t)y * paso; }
+
+    Imagen recorte(int x, int y, int w, int h) const;   // Vista del rectángulo (x, y, w, h), con el mismo paso
+    Imagen franja(int primeraFila, int nFilas) const;   // Vista de nFilas filas completas
+    Imagen clonar() const;                              // Copia compacta, dueña de su buffer
+};
+
+Imagen cargarImagen(const char* ruta);
+bool exportarImagen(const Imagen &imagen, const char* ruta);
+
+// Operaciones byte a byte que se pueden encadenar en una CadenaTransformaciones
+enum TipoOperacion {
+    OP_XOR_IMAGEN,      // x ^ imagen[i]
+    OP_XOR_CONSTANTE,   // x ^ parametro
+    OP_ROTAR_IZQ,       // rotación de parametro bits a la izquierda
+    OP_ROTAR_DER,       // rotación de parametro bits a la derecha
+    OP_DESPLAZAR_IZQ,   // x << parametro (los bits que salen se pierden)
+    OP_DESPLAZAR_DER    // x >> parametro
+};
+
+struct OperacionByte {
+    TipoOperacion tipo;
+    int parametro;
+    const unsigned char* imagen;   // Solo para OP_XOR_IMAGEN; la cadena no es dueña del buffer. Puede
+                                   // ser nullptr si la cadena se aplica por franjas (procesarBMPPorFranjas)
+};
+
+const int MAX_OPERACIONES_CADENA = 64;
+
+// Secuencia de operaciones que, una vez compilada, se aplica con una sola pasada: una tabla de
+// 256 entradas (en forma de dos tablas de 16 para pshufb) más, si hay XOR con imágenes, un XOR con
+// una máscara precalculada.
+struct CadenaTransformaciones {
+    OperacionByte ops[MAX_OPERACIONES_CADENA];
+    int n_ops;
+
+    // Resultado de compilarCadena
+    unsigned char tablaBaja[16];       // f(nibble bajo), incluye la constante
+    unsigned char tablaAlta[16];       // parte lineal de f(nibble alto << 4)
+    bool esIdentidad;                  // la tabla no cambia ningún valor
+    bool hayImagenes;                  // la cadena tiene al menos un OP_XOR_IMAGEN
+    unsigned char tablaImagenBaja[16]; // Suma de las partes lineales que siguen a cada OP_XOR_IMAGEN,
+    unsigned char tablaImagenAlta[16]; // para cuando todas las imágenes son la misma (p. ej. I_M)
+    unsigned char* mascara;            // XOR acumulado de las imágenes ya transformadas (o nullptr)
+    size_t tamanoMascara;
+};
+
+void iniciarCadena(CadenaTransformaciones &cadena);
+bool agregarOperacion(CadenaTransformaciones &cadena, TipoOperacion tipo, int parametro,
+                      const unsigned char* imagen = nullptr);
+void compilarTablasCadena(CadenaTransformaciones &cadena);
+bool compilarCadena(CadenaTransformaciones &cadena, size_t dataSize);
+void aplicarCadena(const CadenaTransformaciones &cadena, const unsigned char* src, unsigned char* dst, size_t dataSize);
+void liberarCadena(CadenaTransformaciones &cadena);
+
+// Archivo proyectado en memoria (mmap en POSIX, MapViewOfFile en Windows), de solo lectura
+struct ArchivoMapeado {
+    const unsigned char* datos;
+    size_t tamano;
+#ifdef _WIN32
+    void* manejadorArchivo;
+    void* manejadorMapeo;
+#endif
+};
+
+// Vista sin copia de los píxeles de un BMP de 24 o 32 bits. Los bytes de cada píxel están en el
+// orden del archivo (B, G, R[, A]) y la fila y (0 = arriba) empieza en primeraFila + y * paso;
+// el paso es negativo en los BMP guardados de abajo hacia arriba, que son los habituales.
+struct VistaBMP {
+    ArchivoMapeado archivo;
+    const unsigned char* primeraFila;
+    ptrdiff_t paso;
+    int width;
+    int height;
+    int bytesPorPixel;
+};
+
+bool mapearArchivo(const char* ruta, ArchivoMapeado &archivo);
+void liberarMapeo(ArchivoMapeado &archivo);
+bool abrirVistaBMP(const char* ruta, VistaBMP &vista);
+void cerrarVistaBMP(VistaBMP &vista);
+
+// Lector de BMP de 24/32 bits por franjas de filas, con lecturas normales en lugar de proyectar el
+// archivo: la memoria usada depende solo del alto de la franja y no del tamaño de la imagen.
+struct LectorBMP {
+    FILE* archivo;
+    int width;
+    int height;
+    int bytesPorPixel;
+    bool deArribaAbajo;
+    size_t bytesFila;
+    unsigned int inicioPixeles;
+    unsigned char* buffer;     // Filas leídas tal como están en el archivo
+    size_t capacidadFilas;
+};
+
+bool abrirLectorBMP(const char* ruta, LectorBMP &lector);
+bool leerFilasBMP(LectorBMP &lector, int primeraFila, int nFilas, unsigned char* rgb);
+void cerrarLectorBMP(LectorBMP &lector);
+
+// Escritor de BMP de 24 bits por franjas de filas. Las filas se convierten de RGB a BGR y se
+// rellenan en un buffer intermedio grande que se vuelca con pocas llamadas a fwrite. El archivo se
+// guarda de abajo hacia arriba como lo hace Qt, de modo que cada franja ocupa un bloque contiguo.
+struct EscritorBMP {
+    FILE* archivo;
+    int width;
+    int height;
+    size_t bytesFila;          // Bytes por fila en el archivo, incluido el relleno
+    unsigned char* buffer;     // Filas ya convertidas pendientes de escribir
+    size_t capacidadFilas;
+    bool error;
+};
+
+bool abrirEscritorBMP(const char* ruta, int width, int height, EscritorBMP &escritor);
+bool escribirFilasBMP(EscritorBMP &escritor, const unsigned char* rgb, int primeraFila, int nFilas);
+bool cerrarEscritorBMP(EscritorBMP &escritor);
+
+bool procesarBMPPorFranjas(const char* entrada, const char* imagenXOR, const char* salida,
+                           CadenaTransformaciones &cadena, int alturaFranja);
 
-    // Exporta la imagen modificada a un nuevo archivo BMP
-    bool exportI = exportImage(pixelData, width, height, archivoSalida);
+// Pipeline perezoso: un grafo de etapas en memoria. Cada etapa se calcula solo cuando algo la
+// necesita (otra etapa, un sumidero o una consulta), y los buffers pasan de una etapa a otra sin
+// tocar el disco. Escribir a disco es opcional: los sumideros (BMP o archivo de enmascaramiento)
+// se ejecutan en hilos aparte mientras el pipeline sigue.
+// Cuando una etapa es la única que lee a otra, se queda con su buffer y lo transforma en el mismo
+// lugar; la etapa cedida vuelve a quedar sin evaluar y, si se la pide otra vez, se recalcula.
+enum TipoEtapa {
+    ETAPA_CARGAR,      // Imagen leída del disco a través del registro de imágenes
+    ETAPA_XOR,         // entrada0 ^ entrada1
+    ETAPA_ROTAR,       // Rotación de entrada0 (parametro > 0: izquierda, < 0: derecha)
+    ETAPA_INVERSA,     // rol(entrada0, parametro) ^ entrada1: deshace XOR + rotación a la derecha
+    ETAPA_COMPARAR     // entrada0 == entrada1 (resultado booleano)
+};
 
-    // Muestra si la exportación fue exitosa (true o false)
-    cout << exportI << endl;
+enum TipoSumidero {
+    SUMIDERO_BMP,              // Exporta la etapa como BMP
+    SUMIDERO_ENMASCARAMIENTO,  // Escribe el archivo de enmascaramiento de la etapa con una máscara
+    SUMIDERO_ENMASCARAMIENTO_BINARIO   // Lo mismo, en el formato binario "DMSK"
+};
 
-    // Libera la memoria usada para los píxeles
-    if (pixelData != nullptr) {
-        delete[] pixelData;
-        pixelData = nullptr;
+struct EtapaPipeline {
+    TipoEtapa tipo;
+    int entradas[2];
+    int parametro;
+    string ruta;                       // Solo para ETAPA_CARGAR
+    int consumidores;                  // Etapas y sumideros que leen esta etapa
+
+    // Resultado (válido cuando evaluada es true)
+    bool evaluada;
+    Imagen imagen;                     // Propia, o vista de la imagen del registro en ETAPA_CARGAR
+    bool iguales;                      // Solo para ETAPA_COMPARAR
+};
+
+struct SumideroPipeline {
+    TipoSumidero tipo;
+    int etapa;
+    int etapaMascara;                  // Solo para los sumideros de enmascaramiento
+    int offset;
+    string ruta;
+    thread hilo;
+    bool ok;
+};
+
+const int MAX_ETAPAS_PIPELINE = 32;
+const int MAX_SUMIDEROS_PIPELINE = 16;
+
+struct Pipeline {
+    EtapaPipeline etapas[MAX_ETAPAS_PIPELINE];
+    int n_etapas;
+    SumideroPipeline sumideros[MAX_SUMIDEROS_PIPELINE];
+    int n_sumideros;
+    int n_sumiderosLanzados;
+};
+
+void iniciarPipeline(Pipeline &pipeline);
+int agregarCarga(Pipeline &pipeline, const char* ruta);
+int agregarEtapa(Pipeline &pipeline, TipoEtapa tipo, int entrada0, int entrada1 = -1, int parametro = 0);
+bool agregarExportacion(Pipeline &pipeline, int etapa, const char* ruta);
+bool agregarEnmascaramiento(Pipeline &pipeline, int etapa, int etapaMascara, int offset, const char* ruta,
+                            bool binario = false);
+bool evaluarEtapa(Pipeline &pipeline, int etapa);
+bool ejecutarPipeline(Pipeline &pipeline);
+bool esperarPipeline(Pipeline &pipeline);
+void liberarPipeline(Pipeline &pipeline);
+
+// Bytes de una imagen RGB de width x height (3 por píxel). Devuelve false si alguna dimensión no es
+// positiva o si el producto no entra en size_t, en lugar de desbordar como width * height * 3 en int.
+bool tamanoImagenRGB(int width, int height, size_t &bytes);
+unsigned char* loadPixels(QString input, int &width, int &height);
+bool exportImage(const unsigned char* pixelData, int width, int height, QString archivoSalida);
+const unsigned char* obtenerImagenCacheada(const char* ruta, int &width, int &height);
+void liberarCacheImagenes();
+unsigned short* loadSeedMasking(const char* nombreArchivo, int &seed, int &n_pixels);
+void applyXOR(const unsigned char* img1, const unsigned char* img2, unsigned char* result, size_t dataSize);
+void rotateBitsRight(unsigned char* data, size_t dataSize, int bits);
+void rotateBitsLeft(unsigned char* data, size_t dataSize, int bits);
+void applyXORRotateRight(const unsigned char* img1, const unsigned char* img2, unsigned char* resultadoXOR,
+                         unsigned char* result, size_t dataSize, int bits);
+void applyRotateLeftXOR(const unsigned char* img1, const unsigned char* img2, unsigned char* result, size_t dataSize, int bits);
+bool generarArchivoEnmascaramiento(const char* archivoSalida, const unsigned char* datos,
+                                   const unsigned char* mascara, int offset, int n_pixels);
+// Formato binario de los archivos de enmascaramiento (little-endian):
+//   bytes 0..3    "DMSK"
+//   bytes 4..5    versión (1)
+//   bytes 6..7    bits por valor (16)
+//   bytes 8..11   semilla (con signo)
+//   bytes 12..15  número de píxeles
+//   bytes 16..19  ancho de la máscara (0 si se desconoce)
+//   bytes 20..23  alto de la máscara (0 si se desconoce)
+//   bytes 24..31  hash64 de los valores
+//   bytes 32..    n_pixels * 3 valores de 16 bits (R, G, B, R, G, B, ...)
+// Los valores quedan alineados a 2 bytes, así que el archivo proyectado se usa sin convertir nada.
+const int TAMANO_CABECERA_ENMASCARAMIENTO = 32;
+// Tope de píxeles de un enmascaramiento, en cualquiera de los dos formatos: así n_pixels * 3 cabe
+// en un int
+const int MAX_PIXELES_ENMASCARAMIENTO = INT_MAX / 3;
+
+struct VistaEnmascaramiento {
+    ArchivoMapeado archivo;
+    const unsigned short* valores;
+    unsigned short* propios;   // Valores interpretados de un archivo de texto; nullptr si son los proyectados
+    int seed;
+    int n_pixels;
+    int width;
+    int height;
+};
+
+bool generarArchivoEnmascaramientoBinario(const char* archivoSalida, const unsigned char* datos,
+                                          const unsigned char* mascara, int offset, int n_pixels,
+                                          int widthMascara, int heightMascara);
+bool abrirVistaEnmascaramiento(const char* nombreArchivo, VistaEnmascaramiento &vista);
+void cerrarVistaEnmascaramiento(VistaEnmascaramiento &vista);
+bool convertirEnmascaramientoTextoABinario(const char* archivoTexto, const char* archivoBinario);
+bool convertirEnmascaramientoBinarioATexto(const char* archivoBinario, const char* archivoTexto);
+unsigned long long hash64(const void* datos, size_t tamano, unsigned long long semilla);
+// Informe de las diferencias entre dos imágenes RGB del mismo tamaño, calculado en una sola pasada.
+// Las coordenadas valen -1 si no hay diferencias. El mapa de calor tiene un contador de bytes
+// distintos por cada bloque de TAMANO_BLOQUE_DIFERENCIAS x TAMANO_BLOQUE_DIFERENCIAS píxeles.
+const int TAMANO_BLOQUE_DIFERENCIAS = 64;
+
+struct ReporteDiferencias {
+    int width;
+    int height;
+    long long bytesDistintos;
+    long long bytesDistintosCanal[3];  // R, G, B
+    int primeraX, primeraY;
+    int ultimaX, ultimaY;
+    int bloquesX, bloquesY;
+    int* mapaCalor;                    // bloquesX * bloquesY contadores, por filas
+};
+
+void calcularDiferencias(const unsigned char* img1, const unsigned char* img2, int width, int height,
+                         ReporteDiferencias &reporte);
+void calcularDiferencias(const Imagen &img1, const Imagen &img2, ReporteDiferencias &reporte);
+void imprimirReporteDiferencias(const ReporteDiferencias &reporte);
+void liberarReporteDiferencias(ReporteDiferencias &reporte);
+
+bool compararImagenes(QString archivo1, QString archivo2, ReporteDiferencias* reporte = nullptr);
+// COMPARAR_BYTES (el predeterminado) exige archivos idénticos; COMPARAR_NUMERICO compara los valores
+// e ignora los espacios y el tipo de salto de línea, para archivos escritos en otra plataforma
+enum ModoComparacion {
+    COMPARAR_BYTES,
+    COMPARAR_NUMERICO
+};
+bool compararArchivos(const char* archivo1, const char* archivo2, ModoComparacion modo = COMPARAR_BYTES);
+
+// Inferencia de las transformaciones aplicadas a I_O a partir de I_D, I_M, M y los archivos de
+// enmascaramiento. archivosEnmascaramiento[k] describe la imagen antes del paso k + 1 (el último
+// describe la imagen a la que se le aplicó el paso que produjo I_D). Los candidatos de cada paso
+// son el XOR con imagenXOR, las rotaciones de 1 a 7 bits y los desplazamientos de 1 a 7 bits.
+bool inferirTransformaciones(const unsigned char* imagenFinal, const unsigned char* imagenXOR, size_t dataSize,
+                             const unsigned char* mascara, size_t tamanoMascara,
+                             const char* const* archivosEnmascaramiento, int n_archivos,
+                             CadenaTransformaciones &inversa);
+
+// Microbenchmark de los kernels de píxeles ("--bench-kernels [MiB máximos]", 128 por defecto)
+bool ejecutarBenchmarkKernels(size_t maxBytes);
+
+// Casos sintéticos deterministas y benchmark de punta a punta ("--bench-pipeline [VGA|HD|FHD|4K|8K|16K]",
+// hasta 16K por defecto)
+enum TipoImagenSintetica {
+    IMAGEN_ALEATORIA,
+    IMAGEN_DEGRADADO,
+    IMAGEN_NATURAL
+};
+unsigned char* generarImagenSintetica(TipoImagenSintetica tipo, int width, int height, unsigned long long semilla);
+void generarCadenaAleatoria(CadenaTransformaciones &cadena, int n_ops, const unsigned char* imagenXOR,
+                            unsigned long long semilla);
+bool ejecutarBenchmarkPipeline(const char* resolucionMaxima, unsigned long long semilla);
+
+// Verificación de los kernels de candidatos de la inferencia contra una referencia escalar por
+// fuerza bruta ("--verificar-inferencia [ventanas aleatorias]", 10000 por defecto)
+bool verificarInferencia(int rondas, unsigned long long semilla);
+
+int main(int argc, char* argv[])
+{
+    // "--trace archivo.json" registra cada etapa y kernel y los vuelca al terminar (en cualquier modo)
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--trace") == 0) activarTrazas(argv[i + 1]);
+    }
+    // "--paginas-grandes" pide páginas de 2 MiB (madvise(MADV_HUGEPAGE)) para los buffers grandes
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--paginas-grandes") == 0) activarPaginasGrandes();
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--bench-kernels") == 0) {
+            size_t maxMiB = (i + 1 < argc) ? (size_t)strtoull(argv[i + 1], nullptr, 10) : 0;
+            if (maxMiB == 0) maxMiB = 128;
+            if (maxMiB > SIZE_MAX / (1024 * 1024)) maxMiB = SIZE_MAX / (1024 * 1024);
+            return ejecutarBenchmarkKernels(maxMiB * 1024 * 1024) ? 0 : 1;
+        }
+        if (strcmp(argv[i], "--bench-pipeline") == 0) {
+            return ejecutarBenchmarkPipeline(i + 1 < argc ? argv[i + 1] : nullptr, 2025) ? 0 : 1;
+        }
+        if (strcmp(argv[i], "--verificar-inferencia") == 0) {
+            int rondas = (i + 1 < argc) ? atoi(argv[i + 1]) : 0;
+            return verificarInferencia(rondas > 0 ? rondas : 10000, 2025) ? 0 : 1;
+        }
+        // "--comparar A.bmp B.bmp": compara dos imágenes del disco y, si difieren, muestra el informe
+        if (strcmp(argv[i], "--comparar") == 0 && i + 2 < argc) {
+            ReporteDiferencias reporte;
+            bool iguales = compararImagenes(argv[i + 1], argv[i + 2], &reporte);
+            if (iguales) {
+                cout << argv[i + 1] << " y " << argv[i + 2] << " tienen los mismos píxeles." << endl;
+            } else {
+                cout << argv[i + 1] << " y " << argv[i + 2] << " son distintas." << endl;
+                if (reporte.mapaCalor != nullptr) imprimirReporteDiferencias(reporte);
+                liberarReporteDiferencias(reporte);
+            }
+            liberarCacheImagenes();
+            vaciarPoolBuffers();
+            return iguales ? 0 : 1;
+        }
+        // "--a-binario M.txt M.msk" y "--a-texto M.msk M.txt" convierten un archivo de enmascaramiento
+        // de un formato al otro
+        if (strcmp(argv[i], "--a-binario") == 0 && i + 2 < argc) {
+            return convertirEnmascaramientoTextoABinario(argv[i + 1], argv[i + 2]) ? 0 : 1;
+        }
+        if (strcmp(argv[i], "--a-texto") == 0 && i + 2 < argc) {
+            return convertirEnmascaramientoBinarioATexto(argv[i + 1], argv[i + 2]) ? 0 : 1;
+        }
+    }
+
+    // Modo por franjas: "--franjas N" genera P2.bmp (XOR con I_M y rotación de 3 bits a la derecha)
+    // leyendo y escribiendo de a N filas, sin cargar las imágenes completas en memoria
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--franjas") == 0) {
+            CadenaTransformaciones cadena;
+            iniciarCadena(cadena);
+            agregarOperacion(cadena, OP_XOR_IMAGEN, 0);
+            agregarOperacion(cadena, OP_ROTAR_DER, 3);
+            bool ok = procesarBMPPorFranjas("I_O.bmp", "I_M.bmp", "P2.bmp", cadena, atoi(argv[i + 1]));
+            liberarCadena(cadena);
+            return ok ? 0 : 1;
+        }
     }
 
-    // Libera la memoria de la imagen de distorsión
-    if (imgM != nullptr) {
-        delete[] imgM;
-        imgM = nullptr;
+    // "--intermedios" pide escribir también P1.bmp, P2.bmp y P3.bmp; sin él esas imágenes solo
+    // existen en memoria
+    // "--binario" agrega las versiones binarias M1.msk y M2.msk de los archivos de enmascaramiento
+    bool exportarIntermedios = false;
+    bool enmascaramientoBinario = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--intermedios") == 0) exportarIntermedios = true;
+        if (strcmp(argv[i], "--binario") == 0) enmascaramientoBinario = true;
     }
 
     // Variables para almacenar la semilla y el número de píxeles leídos del archivo de enmascaramiento
     int seed = 0;
     int n_pixels = 0;
 
-    // Carga los datos de enmascaramiento desde un archivo .txt (semilla + valores RGB)
-    unsigned int *maskingData = loadSeedMasking("M1.txt", seed, n_pixels);
+    // Carga los datos de enmascaramiento desde un archivo .txt (semilla + valores RGB), antes de que
+    // el pipeline lo vuelva a generar
+    unsigned short *maskingData = loadSeedMasking("M1.txt", seed, n_pixels);
 
     // Muestra en consola los primeros valores RGB leídos desde el archivo de enmascaramiento
-    for (int i = 0; i < n_pixels * 3; i += 3) {
+    for (size_t i = 0; i < (size_t)n_pixels * 3; i += 3) {
         cout << "Pixel " << i / 3 << ": ("
              << maskingData[i] << ", "
              << maskingData[i + 1] << ", "
              << maskingData[i + 2] << ")" << endl;
     }
 
-    int wMask = 0, hMask = 0;
-    unsigned char* maskTemp = loadPixels("M.bmp", wMask, hMask);
-    if (maskTemp == nullptr) {
-        cout << "Error al cargar M.bmp para calcular tamaño de máscara." << endl;
-        return 1;
-    }
-    n_pixels = wMask * hMask;
-    delete[] maskTemp;
-
-    int widthP2 = 0, heightP2 = 0;
-    unsigned char* p2Image = loadPixels("P2.bmp", widthP2, heightP2);
-    if (p2Image == nullptr) {
-        cout << "Error al cargar P2.bmp para generar M1.txt" << endl;
-        return 1;
-    }
-
-    int widthP1 = 0, heightP1 = 0;
-    unsigned char* p1Image = loadPixels("P1.bmp", widthP1, heightP1);
-    if (p1Image != nullptr) {
-        generarM2DesdeP1(p1Image, 100, n_pixels);
-        delete[] p1Image;
-    } else {
-        cout << "No se pudo cargar P1.bmp para generar M2.txt" << endl;
+    if (maskingData != nullptr) {
+        delete[] maskingData;
+        maskingData = nullptr;
     }
 
-    generarM1DesdeP2(p2Image, 100, n_pixels);
-    delete[] p2Image;
-
-
-    // Recuperar imagen original desde enmascarada (inversión de L_D a L_O)
-    unsigned char* l_d = loadPixels("P2.bmp", width, height);
-    unsigned char* i_m = loadPixels("I_M.bmp", width2, height2);
-    if (l_d != nullptr && i_m != nullptr) {
-        rotateBitsLeft(l_d, width * height * 3, 3);
-        unsigned char* recuperada = new unsigned char[width * height * 3];
-        applyXOR(l_d, i_m, recuperada, width * height * 3);
-        exportImage(recuperada, width, height, "P3.bmp");
+    // Grafo del proceso: P1 = I_O ^ I_M, P2 = ror(P1, 3), P3 = rol(P2, 3) ^ I_M (debe ser I_O).
+    // Nada se calcula hasta que un sumidero o una consulta lo necesita.
+    Pipeline pipeline;
+    iniciarPipeline(pipeline);
+    int io = agregarCarga(pipeline, "I_O.bmp");
+    int im = agregarCarga(pipeline, "I_M.bmp");
+    int mascara = agregarCarga(pipeline, "M.bmp");
+    int p1 = agregarEtapa(pipeline, ETAPA_XOR, io, im);
+    int p2 = agregarEtapa(pipeline, ETAPA_ROTAR, p1, -1, -3);
+    int p3 = agregarEtapa(pipeline, ETAPA_INVERSA, p2, im, 3);
+    int comparacion = agregarEtapa(pipeline, ETAPA_COMPARAR, p3, io);
 
-
-        if (recuperada != nullptr) {
-            delete[] recuperada;
-            recuperada = nullptr;
-        }
-        if (l_d != nullptr) {
-            delete[] l_d;
-            l_d = nullptr;
-        }
+    if (exportarIntermedios) {
+        agregarExportacion(pipeline, p1, "P1.bmp");
+        agregarExportacion(pipeline, p2, "P2.bmp");
+        agregarExportacion(pipeline, p3, "P3.bmp");
     }
-    if (i_m != nullptr) {
-        delete[] i_m;
-        i_m = nullptr;
+    agregarEnmascaramiento(pipeline, p1, mascara, 100, "M2.txt");
+    agregarEnmascaramiento(pipeline, p2, mascara, 100, "M1.txt");
+    if (enmascaramientoBinario) {
+        agregarEnmascaramiento(pipeline, p1, mascara, 100, "M2.msk", true);
+        agregarEnmascaramiento(pipeline, p2, mascara, 100, "M1.msk", true);
     }
 
-    if (maskingData != nullptr) {
-        delete[] maskingData;
-        maskingData = nullptr;
+    // Lanza las escrituras en segundo plano y, mientras tanto, compara P3 con I_O en memoria
+    if (!ejecutarPipeline(pipeline)) {
+        cout << "No se pudo aplicar XOR. Verifica que las imágenes tengan el mismo tamaño y estén bien cargadas." << endl;
     }
 
-    if (compararImagenes("P3.bmp", "I_O.bmp")) {
-        cout << "La imagen recuperada (P3.bmp) es idéntica a I_O.bmp" << endl;
+    if (evaluarEtapa(pipeline, comparacion) && pipeline.etapas[comparacion].iguales) {
+        cout << "La imagen recuperada (P3) es idéntica a I_O.bmp" << endl;
     } else {
         cout << "La imagen recuperada no coincide con I_O.bmp" << endl;
+        // Informe de dónde y cuánto difieren, sin volver a leer los archivos
+        const Imagen &recuperada = pipeline.etapas[p3].imagen;
+        const Imagen &original = pipeline.etapas[io].imagen;
+        if (pipeline.etapas[p3].evaluada && pipeline.etapas[io].evaluada && recuperada.width == original.width &&
+            recuperada.height == original.height) {
+            ReporteDiferencias reporte;
+            calcularDiferencias(recuperada, original, reporte);
+            imprimirReporteDiferencias(reporte);
+            liberarReporteDiferencias(reporte);
+        }
     }
 
+    // Simula una modificación de la imagen asignando valores RGB incrementales
+    // (Esto es solo un ejemplo de manipulación artificial)
+    Imagen modificada;
+    if (evaluarEtapa(pipeline, io)) modificada = Imagen(pipeline.etapas[io].imagen.width, pipeline.etapas[io].imagen.height);
+    if (!modificada.vacia()) {
+        size_t dataSize = modificada.bytes();
+        unsigned char* pixelData = modificada.propio;
+        for (size_t i = 0; i < dataSize; i += 3) {
+            pixelData[i] = i;     // Canal rojo
+            pixelData[i + 1] = i; // Canal verde
+            pixelData[i + 2] = i; // Canal azul
+        }
+
+        // Exporta la imagen modificada a un nuevo archivo BMP
+        bool exportI = exportarImagen(modificada, "I_D.bmp");
+
+        // Muestra si la exportación fue exitosa (true o false)
+        cout << exportI << endl;
+    }
+
+    // Los archivos de enmascaramiento tienen que estar escritos antes de compararlos
+    esperarPipeline(pipeline);
+
     if (compararArchivos("M1.txt", "M1_generado.txt")) {
         cout << "M1.txt y M1_generado.txt son iguales." << endl;
     } else {
@@ -213,289 +652,4214 @@ int main()
         cout << "M2.txt y M2_generado.txt tienen diferencias." << endl;
     }
 
+    // Inferencia: a partir de P2 (como imagen final) y de M2 (que describe P1) se deduce el último
+    // paso y se verifica que su inversa reconstruye P1. Con "--binario" se lee M2.msk, sin copiarlo.
+    if (evaluarEtapa(pipeline, p1) && evaluarEtapa(pipeline, p2) && evaluarEtapa(pipeline, im) &&
+        evaluarEtapa(pipeline, mascara)) {
+        const Imagen &final = pipeline.etapas[p2].imagen;
+        size_t dataSize = final.bytes();
+        size_t tamanoMascara = pipeline.etapas[mascara].imagen.bytes();
+        const char* archivos[] = {enmascaramientoBinario ? "M2.msk" : "M2.txt"};
+        CadenaTransformaciones inversa;
+        if (inferirTransformaciones(final.datos, pipeline.etapas[im].imagen.datos, dataSize,
+                                    pipeline.etapas[mascara].imagen.datos, tamanoMascara, archivos, 1, inversa) &&
+            compilarCadena(inversa, dataSize)) {
+            Imagen reconstruida(final.width, final.height);
+            if (!reconstruida.vacia()) {
+                aplicarCadena(inversa, final.datos, reconstruida.propio, dataSize);
+                if (memcmp(reconstruida.datos, pipeline.etapas[p1].imagen.datos, dataSize) == 0) {
+                    cout << "La inversa inferida reconstruye P1 a partir de P2." << endl;
+                } else {
+                    cout << "La inversa inferida no reconstruye P1." << endl;
+                }
+            }
+        }
+        liberarCadena(inversa);
+    }
+
+    // Libera los buffers del pipeline y todas las imágenes del registro (I_O, I_M y M), y devuelve
+    // al sistema los buffers que quedaron en el pool
+    liberarPipeline(pipeline);
+    liberarCacheImagenes();
+    vaciarPoolBuffers();
+
     return 0; // Fin del programa
 }
 
 
-unsigned char* loadPixels(QString input, int &width, int &height){
-    /*
- * @brief Carga una imagen BMP desde un archivo y extrae los datos de píxeles en formato RGB.
- *
- * Esta función utiliza la clase QImage de Qt para abrir una imagen en formato BMP, convertirla al
- * formato RGB888 (24 bits: 8 bits por canal), y copiar sus datos de píxeles a un arreglo dinámico
- * de tipo unsigned char. El arreglo contendrá los valores de los canales Rojo, Verde y Azul (R, G, B)
- * de cada píxel de la imagen, sin rellenos (padding).
- *
- * @param input Ruta del archivo de imagen BMP a cargar (tipo QString).
- * @param width Parámetro de salida que contendrá el ancho de la imagen cargada (en píxeles).
- * @param height Parámetro de salida que contendrá la altura de la imagen cargada (en píxeles).
- * @return Puntero a un arreglo dinámico que contiene los datos de los píxeles en formato RGB.
- *         Devuelve nullptr si la imagen no pudo cargarse.
- *
- * @note Es responsabilidad del usuario liberar la memoria asignada al arreglo devuelto usando `delete[]`.
- */
-
-    // Cargar la imagen BMP desde el archivo especificado (usando Qt)
-    QImage imagen(input);
+// ---------------------------------------------------------------------------------------------
+// Buffers de píxeles
+//
+// Clases de tamaño: hasta 4 KiB una sola clase; por encima, cuatro clases por cada potencia de dos
+// (2^e, 1.25 * 2^e, 1.5 * 2^e, 1.75 * 2^e), así que un buffer desperdicia a lo sumo un 25 %. Cada
+// bloque lleva delante una cabecera de una línea de caché con su clase y su capacidad, y mientras
+// está en el pool esa cabecera lo enlaza con el resto de los bloques libres de su clase.
+// ---------------------------------------------------------------------------------------------
 
-    // Verifica si la imagen fue cargada correctamente
-    if (imagen.isNull()) {
-        cout << "Error: No se pudo cargar la imagen BMP." << std::endl;
-        return nullptr; // Retorna un puntero nulo si la carga falló
-    }
+const size_t MIN_CLASE_BUFFER = 4096;
+const int N_CLASES_BUFFER = 4 * 64;
+const size_t TAMANO_PAGINA_GRANDE = (size_t)2 << 20;
+const size_t MAX_BYTES_POOL_BUFFERS = (size_t)2 << 30;   // Lo que exceda se devuelve al sistema
 
-    // Convierte la imagen al formato RGB888 (3 canales de 8 bits sin transparencia)
-    imagen = imagen.convertToFormat(QImage::Format_RGB888);
+struct CabeceraBuffer {
+    size_t capacidad;
+    int clase;
+    CabeceraBuffer* siguiente;   // Siguiente bloque libre de la misma clase
+};
 
-    // Obtiene el ancho y el alto de la imagen cargada
-    width = imagen.width();
-    height = imagen.height();
+static_assert(sizeof(CabeceraBuffer) <= TAMANO_LINEA_CACHE, "la cabecera debe caber en una línea de caché");
 
-    // Calcula el tamaño total de datos (3 bytes por píxel: R, G, B)
-    int dataSize = width * height * 3;
+static mutex mutexPoolBuffers;
+static CabeceraBuffer* buffersLibres[N_CLASES_BUFFER] = {};
+static size_t bytesPoolBuffers = 0;
+static bool paginasGrandes = false;   // Solo se cambia al arrancar, antes de que haya otros hilos
 
-    // Reserva memoria dinámica para almacenar los valores RGB de cada píxel
-    unsigned char* pixelData = new unsigned char[dataSize];
+void activarPaginasGrandes() {
+    paginasGrandes = true;
+}
 
-    // Copia cada línea de píxeles de la imagen Qt a nuestro arreglo lineal
-    for (int y = 0; y < height; ++y) {
-        const uchar* srcLine = imagen.scanLine(y);                // Línea original de la imagen con posible padding
-        unsigned char* dstLine = pixelData + y * width * 3;       // Línea destino en el arreglo lineal sin padding
-        memcpy(dstLine, srcLine, width * 3);                      // Copia los píxeles RGB de esa línea (sin padding)
+static int claseBuffer(size_t bytes, size_t &capacidad) {
+    if (bytes <= MIN_CLASE_BUFFER) {
+        capacidad = MIN_CLASE_BUFFER;
+        return 0;
     }
-
-    // Retorna el puntero al arreglo de datos de píxeles cargado en memoria
-    return pixelData;
+    int e = 63 - __builtin_clzll((unsigned long long)(bytes - 1));   // 2^e < bytes <= 2^(e + 1)
+    size_t base = (size_t)1 << e;
+    size_t cuarto = base / 4;
+    size_t k = (bytes - base + cuarto - 1) / cuarto;                 // 1..4
+    capacidad = base + k * cuarto;
+    return (e - 12) * 4 + (int)k;
 }
 
-bool exportImage(unsigned char* pixelData, int width,int height, QString archivoSalida){
-    /*
- * @brief Exporta una imagen en formato BMP a partir de un arreglo de píxeles en formato RGB.
- *
- * Esta función crea una imagen de tipo QImage utilizando los datos contenidos en el arreglo dinámico
- * `pixelData`, que debe representar una imagen en formato RGB888 (3 bytes por píxel, sin padding).
- * A continuación, copia los datos línea por línea a la imagen de salida y guarda el archivo resultante
- * en formato BMP en la ruta especificada.
- *
- * @param pixelData Puntero a un arreglo de bytes que contiene los datos RGB de la imagen a exportar.
- *                  El tamaño debe ser igual a width * height * 3 bytes.
- * @param width Ancho de la imagen en píxeles.
- * @param height Alto de la imagen en píxeles.
- * @param archivoSalida Ruta y nombre del archivo de salida en el que se guardará la imagen BMP (QString).
- *
- * @return true si la imagen se guardó exitosamente; false si ocurrió un error durante el proceso.
- *
- * @note La función no libera la memoria del arreglo pixelData; esta responsabilidad recae en el usuario.
- */
+static void* reservarAlineado(size_t alineacion, size_t bytes) {
+#ifdef _WIN32
+    return _aligned_malloc(bytes, alineacion);
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, alineacion, bytes) != 0) return nullptr;
+#ifdef MADV_HUGEPAGE
+    if (paginasGrandes && alineacion == TAMANO_PAGINA_GRANDE) madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+    return p;
+#endif
+}
 
-    // Crear una nueva imagen de salida con el mismo tamaño que la original
-    // usando el formato RGB888 (3 bytes por píxel, sin canal alfa)
-    QImage outputImage(width, height, QImage::Format_RGB888);
+static void liberarAlineado(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
 
-    // Copiar los datos de píxeles desde el buffer al objeto QImage
-    for (int y = 0; y < height; ++y) {
-        // outputImage.scanLine(y) devuelve un puntero a la línea y-ésima de píxeles en la imagen
-        // pixelData + y * width * 3 apunta al inicio de la línea y-ésima en el buffer (sin padding)
-        // width * 3 son los bytes a copiar (3 por píxel)
-        memcpy(outputImage.scanLine(y), pixelData + y * width * 3, width * 3);
+unsigned char* reservarBufferPixeles(size_t bytes) {
+    size_t capacidad;
+    int clase = claseBuffer(bytes, capacidad);
+    {
+        lock_guard<mutex> candado(mutexPoolBuffers);
+        CabeceraBuffer* libre = buffersLibres[clase];
+        if (libre != nullptr) {
+            buffersLibres[clase] = libre->siguiente;
+            bytesPoolBuffers -= libre->capacidad;
+            return (unsigned char*)libre + TAMANO_LINEA_CACHE;
+        }
     }
 
-    // Guardar la imagen en disco como archivo BMP
-    if (!outputImage.save(archivoSalida, "BMP")) {
-        // Si hubo un error al guardar, mostrar mensaje de error
-        cout << "Error: No se pudo guardar la imagen BMP modificada.";
-        return false; // Indica que la operación falló
-    } else {
-        // Si la imagen fue guardada correctamente, mostrar mensaje de éxito
-        cout << "Imagen BMP modificada guardada como " << archivoSalida.toStdString() << endl;
-        return true; // Indica éxito
+    SpanTraza traza("reservar buffer nuevo", capacidad);
+    size_t alineacion = capacidad >= TAMANO_PAGINA_GRANDE ? TAMANO_PAGINA_GRANDE : TAMANO_LINEA_CACHE;
+    CabeceraBuffer* cabecera = (CabeceraBuffer*)reservarAlineado(alineacion, capacidad + TAMANO_LINEA_CACHE);
+    if (cabecera == nullptr) throw bad_alloc();
+    cabecera->capacidad = capacidad;
+    cabecera->clase = clase;
+    cabecera->siguiente = nullptr;
+    return (unsigned char*)cabecera + TAMANO_LINEA_CACHE;
+}
+
+void liberarBufferPixeles(unsigned char* buffer) {
+    if (buffer == nullptr) return;
+    CabeceraBuffer* cabecera = (CabeceraBuffer*)(buffer - TAMANO_LINEA_CACHE);
+    {
+        lock_guard<mutex> candado(mutexPoolBuffers);
+        if (bytesPoolBuffers + cabecera->capacidad <= MAX_BYTES_POOL_BUFFERS) {
+            cabecera->siguiente = buffersLibres[cabecera->clase];
+            buffersLibres[cabecera->clase] = cabecera;
+            bytesPoolBuffers += cabecera->capacidad;
+            return;
+        }
     }
+    liberarAlineado(cabecera);
 }
 
-// Para aplicar el XOR
-void applyXOR(unsigned char* img1, unsigned char* img2, unsigned char* result, int dataSize) {
-    for (int i = 0; i < dataSize; ++i) {
-        result[i] = img1[i] ^ img2[i];
+void vaciarPoolBuffers() {
+    lock_guard<mutex> candado(mutexPoolBuffers);
+    for (int c = 0; c < N_CLASES_BUFFER; ++c) {
+        while (buffersLibres[c] != nullptr) {
+            CabeceraBuffer* libre = buffersLibres[c];
+            buffersLibres[c] = libre->siguiente;
+            liberarAlineado(libre);
+        }
     }
+    bytesPoolBuffers = 0;
 }
-// Para la rotacion de bits a la derecha
-void rotateBitsRight(unsigned char* data, int dataSize, int bits) {
-    for (int i = 0; i < dataSize; ++i) {
-        data[i] = (data[i] >> bits) | (data[i] << (8 - bits));
+
+// ---------------------------------------------------------------------------------------------
+// Imágenes en memoria
+// ---------------------------------------------------------------------------------------------
+
+int bytesPorPixelFormato(FormatoImagen formato) {
+    switch (formato) {
+    case FORMATO_RGB888: return 3;
     }
+    return 3;
 }
-// Para la rotacion de bits a la izquierda
-void rotateBitsLeft(unsigned char* data, int dataSize, int bits) {
-    for (int i = 0; i < dataSize; ++i) {
-        data[i] = (data[i] << bits) | (data[i] >> (8 - bits));
+
+Imagen::Imagen(int width, int height, FormatoImagen formato)
+    : datos(nullptr), width(0), height(0), paso(0), formato(formato), propio(nullptr) {
+    size_t bytes = 0;
+    if (!tamanoImagenRGB(width, height, bytes)) {
+        cout << "Error: dimensiones de imagen inválidas (" << width << "x" << height << ")." << endl;
+        return;
     }
+    propio = reservarBufferPixeles(bytes);
+    datos = propio;
+    this->width = width;
+    this->height = height;
+    paso = (size_t)width * bytesPorPixelFormato(formato);
 }
 
-unsigned int* loadSeedMasking(const char* nombreArchivo, int &seed, int &n_pixels){
-    /*
- * @brief Carga la semilla y los resultados del enmascaramiento desde un archivo de texto.
- *
- * Esta función abre un archivo de texto que contiene una semilla en la primera línea y,
- * a continuación, una lista de valores RGB resultantes del proceso de enmascaramiento.
- * Primero cuenta cuántos tripletes de píxeles hay, luego reserva memoria dinámica
- * y finalmente carga los valores en un arreglo de enteros.
- *
- * @param nombreArchivo Ruta del archivo de texto que contiene la semilla y los valores RGB.
- * @param seed Variable de referencia donde se almacenará el valor entero de la semilla.
- * @param n_pixels Variable de referencia donde se almacenará la cantidad de píxeles leídos
- *                 (equivalente al número de líneas después de la semilla).
- *
- * @return Puntero a un arreglo dinámico de enteros que contiene los valores RGB
- *         en orden secuencial (R, G, B, R, G, B, ...). Devuelve nullptr si ocurre un error al abrir el archivo.
- *
- * @note Es responsabilidad del usuario liberar la memoria reservada con delete[].
- */
+Imagen::Imagen(Imagen &&otra) noexcept
+    : datos(otra.datos), width(otra.width), height(otra.height), paso(otra.paso), formato(otra.formato),
+      propio(otra.propio) {
+    otra.datos = nullptr;
+    otra.propio = nullptr;
+    otra.width = 0;
+    otra.height = 0;
+    otra.paso = 0;
+}
 
-    // Abrir el archivo que contiene la semilla y los valores RGB
-    ifstream archivo(nombreArchivo);
-    if (!archivo.is_open()) {
-        // Verificar si el archivo pudo abrirse correctamente
-        cout << "No se pudo abrir el archivo." << endl;
-        return nullptr;
+Imagen &Imagen::operator=(Imagen &&otra) noexcept {
+    if (this != &otra) {
+        liberarBufferPixeles(propio);
+        datos = otra.datos;
+        width = otra.width;
+        height = otra.height;
+        paso = otra.paso;
+        formato = otra.formato;
+        propio = otra.propio;
+        otra.datos = nullptr;
+        otra.propio = nullptr;
+        otra.width = 0;
+        otra.height = 0;
+        otra.paso = 0;
     }
+    return *this;
+}
 
-    // Leer la semilla desde la primera línea del archivo
-    archivo >> seed;
+Imagen Imagen::adoptar(unsigned char* buffer, int width, int height, FormatoImagen formato) {
+    Imagen imagen;
+    if (buffer == nullptr) return imagen;
+    imagen.datos = buffer;
+    imagen.propio = buffer;
+    imagen.width = width;
+    imagen.height = height;
+    imagen.formato = formato;
+    imagen.paso = (size_t)width * bytesPorPixelFormato(formato);
+    return imagen;
+}
 
-    int r, g, b;
+Imagen Imagen::vistaDe(const unsigned char* datos, int width, int height, size_t paso, FormatoImagen formato) {
+    Imagen imagen;
+    if (datos == nullptr) return imagen;
+    imagen.datos = datos;
+    imagen.width = width;
+    imagen.height = height;
+    imagen.formato = formato;
+    imagen.paso = paso != 0 ? paso : (size_t)width * bytesPorPixelFormato(formato);
+    return imagen;
+}
 
-    // Contar cuántos grupos de valores RGB hay en el archivo
-    // Se asume que cada línea después de la semilla tiene tres valores (r, g, b)
-    while (archivo >> r >> g >> b) {
-        n_pixels++; // Contamos la cantidad de píxeles
+Imagen Imagen::recorte(int x, int y, int w, int h) const {
+    if (x < 0 || y < 0 || w <= 0 || h <= 0 || x > width - w || y > height - h) {
+        cout << "Error: el recorte (" << x << ", " << y << ", " << w << "x" << h << ") no cabe en la imagen de "
+             << width << "x" << height << "." << endl;
+        return Imagen();
     }
+    return vistaDe(fila(y) + (size_t)x * bytesPorPixel(), w, h, paso, formato);
+}
 
-    // Cerrar el archivo para volver a abrirlo desde el inicio
-    archivo.close();
-    archivo.open(nombreArchivo);
+Imagen Imagen::franja(int primeraFila, int nFilas) const {
+    return recorte(0, primeraFila, width, nFilas);
+}
 
-    // Verificar que se pudo reabrir el archivo correctamente
-    if (!archivo.is_open()) {
-        cout << "Error al reabrir el archivo." << endl;
-        return nullptr;
+Imagen Imagen::clonar() const {
+    if (vacia()) return Imagen();
+    Imagen copia(width, height, formato);
+    if (copia.vacia()) return copia;
+    if (continua()) {
+        memcpy(copia.propio, datos, bytes());
+    } else {
+        size_t bytesFila = (size_t)width * bytesPorPixel();
+        for (int y = 0; y < height; ++y) memcpy(copia.propio + (size_t)y * copia.paso, fila(y), bytesFila);
     }
+    return copia;
+}
 
-    // Reservar memoria dinámica para guardar todos los valores RGB
-    // Cada píxel tiene 3 componentes: R, G y B
-    unsigned int* RGB = new unsigned int[n_pixels * 3];
+// Carga un BMP como imagen dueña de sus píxeles (vacía si no se pudo cargar)
+Imagen cargarImagen(const char* ruta) {
+    int width = 0, height = 0;
+    unsigned char* pixeles = loadPixels(ruta, width, height);
+    return Imagen::adoptar(pixeles, width, height);
+}
 
-    // Leer nuevamente la semilla desde el archivo (se descarta su valor porque ya se cargó antes)
-    archivo >> seed;
+// Exporta una imagen o una vista. Las vistas con filas no contiguas se escriben fila por fila, sin
+// compactarlas antes en otro buffer.
+bool exportarImagen(const Imagen &imagen, const char* ruta) {
+    if (imagen.vacia()) return false;
+    if (imagen.continua()) return exportImage(imagen.datos, imagen.width, imagen.height, ruta);
 
-    // Leer y almacenar los valores RGB uno por uno en el arreglo dinámico
-    for (int i = 0; i < n_pixels * 3; i += 3) {
-        archivo >> r >> g >> b;
-        RGB[i] = r;
-        RGB[i + 1] = g;
-        RGB[i + 2] = b;
+    EscritorBMP escritor;
+    bool guardada = abrirEscritorBMP(ruta, imagen.width, imagen.height, escritor);
+    for (int y = 0; guardada && y < imagen.height; ++y) {
+        guardada = escribirFilasBMP(escritor, imagen.fila(y), y, 1);
+    }
+    guardada = cerrarEscritorBMP(escritor) && guardada;
+    if (guardada) {
+        cout << "Imagen BMP modificada guardada como " << ruta << endl;
+    } else {
+        cout << "Error: No se pudo guardar la imagen BMP " << ruta << endl;
     }
+    return guardada;
+}
 
-    // Cerrar el archivo después de terminar la lectura
-    archivo.close();
+// ---------------------------------------------------------------------------------------------
+// Lectura nativa de BMP
+//
+// Los BMP sin comprimir de 24 y 32 bits se leen proyectando el archivo en memoria y convirtiendo
+// cada fila de BGR(A) a RGB directamente en el buffer de salida, sin pasar por QImage. Cualquier
+// otro formato (paletas, RLE, máscaras de bits) sigue cargándose con Qt.
+// ---------------------------------------------------------------------------------------------
 
-    // Mostrar información de control en consola
-    cout << "Semilla: " << seed << endl;
-    cout << "Cantidad de píxeles leídos: " << n_pixels << endl;
+bool mapearArchivo(const char* ruta, ArchivoMapeado &archivo) {
+    archivo.datos = nullptr;
+    archivo.tamano = 0;
+#ifdef _WIN32
+    archivo.manejadorArchivo = nullptr;
+    archivo.manejadorMapeo = nullptr;
+    HANDLE hArchivo = CreateFileA(ruta, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (hArchivo == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER tamano;
+    if (!GetFileSizeEx(hArchivo, &tamano) || tamano.QuadPart == 0) {
+        CloseHandle(hArchivo);
+        return false;
+    }
+    HANDLE hMapeo = CreateFileMappingA(hArchivo, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (hMapeo == nullptr) {
+        CloseHandle(hArchivo);
+        return false;
+    }
+    void* datos = MapViewOfFile(hMapeo, FILE_MAP_READ, 0, 0, 0);
+    if (datos == nullptr) {
+        CloseHandle(hMapeo);
+        CloseHandle(hArchivo);
+        return false;
+    }
+    archivo.manejadorArchivo = hArchivo;
+    archivo.manejadorMapeo = hMapeo;
+    archivo.datos = (const unsigned char*)datos;
+    archivo.tamano = (size_t)tamano.QuadPart;
+#else
+    int fd = open(ruta, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* datos = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // La proyección sigue siendo válida después de cerrar el descriptor
+    if (datos == MAP_FAILED) return false;
+    madvise(datos, (size_t)info.st_size, MADV_SEQUENTIAL);
+    archivo.datos = (const unsigned char*)datos;
+    archivo.tamano = (size_t)info.st_size;
+#endif
+    return true;
+}
 
-    // Retornar el puntero al arreglo con los datos RGB
-    return RGB;
+void liberarMapeo(ArchivoMapeado &archivo) {
+    if (archivo.datos == nullptr) return;
+#ifdef _WIN32
+    UnmapViewOfFile(archivo.datos);
+    CloseHandle(archivo.manejadorMapeo);
+    CloseHandle(archivo.manejadorArchivo);
+#else
+    munmap((void*)archivo.datos, archivo.tamano);
+#endif
+    archivo.datos = nullptr;
+    archivo.tamano = 0;
 }
 
+// Lectura de enteros little-endian de la cabecera (el formato BMP es little-endian siempre)
+static unsigned int leerU16(const unsigned char* p) {
+    return (unsigned int)p[0] | ((unsigned int)p[1] << 8);
+}
 
+static unsigned int leerU32(const unsigned char* p) {
+    return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
 
-void generarM1DesdeP2(unsigned char* p2, int offset, int n_pixels) {
-    int wM = 0;
-    int hM = 0;
-    unsigned char* mask = loadPixels("M.bmp", wM, hM);
+// Datos de la cabecera de un BMP de 24/32 bits sin comprimir
+struct InfoBMP {
+    int width;
+    int height;
+    int bytesPorPixel;
+    bool deArribaAbajo;
+    size_t bytesFila;            // Incluye el relleno hasta múltiplo de 4
+    unsigned int inicioPixeles;
+};
 
-    if (mask == nullptr) {
-        cout << "No se pudo cargar la máscara M.bmp" << endl;
-        return;
-    }
+// Interpreta los primeros 54 bytes de un BMP; falla si no es BI_RGB de 24 o 32 bits
+static bool analizarCabeceraBMP(const unsigned char* d, InfoBMP &info) {
+    // BITMAPFILEHEADER (14 bytes) + al menos un BITMAPINFOHEADER (40 bytes)
+    if (d[0] != 'B' || d[1] != 'M') return false;
+    unsigned int inicioPixeles = leerU32(d + 10);
+    unsigned int tamanoCabecera = leerU32(d + 14);
+    int ancho = (int)leerU32(d + 18);
+    int alto = (int)leerU32(d + 22);
+    unsigned int planos = leerU16(d + 26);
+    unsigned int bpp = leerU16(d + 28);
+    unsigned int compresion = leerU32(d + 30);
 
-    ofstream out("M1.txt");
-    if (!out.is_open()) {
-        cout << "Error al crear M1.txt" << endl;
-        delete[] mask;
-        return;
+    // Solo BI_RGB (sin compresión) de 24 o 32 bits
+    if (tamanoCabecera < 40 || planos != 1 || compresion != 0 || (bpp != 24 && bpp != 32) ||
+        ancho <= 0 || alto == 0 || alto == INT_MIN || inicioPixeles < 54) {
+        return false;
     }
 
-    out << offset << endl;
+    info.deArribaAbajo = alto < 0;
+    info.width = ancho;
+    info.height = info.deArribaAbajo ? -alto : alto;
+    info.bytesPorPixel = (int)(bpp / 8);
+    // Cada fila del archivo está rellenada hasta un múltiplo de 4 bytes
+    info.bytesFila = (((size_t)ancho * bpp + 31) / 32) * 4;
+    info.inicioPixeles = inicioPixeles;
+    return true;
+}
+
+bool abrirVistaBMP(const char* ruta, VistaBMP &vista) {
+    if (!mapearArchivo(ruta, vista.archivo)) return false;
+
+    const unsigned char* d = vista.archivo.datos;
+    size_t tamano = vista.archivo.tamano;
 
-    for (int i = 0; i < n_pixels * 3; i += 3) {
-        int r = p2[offset * 3 + i] + mask[i];
-        int g = p2[offset * 3 + i + 1] + mask[i + 1];
-        int b = p2[offset * 3 + i + 2] + mask[i + 2];
-        out << r << " " << g << " " << b << endl;
+    InfoBMP info;
+    if (tamano < 54 || !analizarCabeceraBMP(d, info)) {
+        liberarMapeo(vista.archivo);
+        return false;
+    }
+    if (info.inicioPixeles > tamano || info.bytesFila * (size_t)info.height > tamano - info.inicioPixeles) {
+        cout << "Error: el archivo BMP está truncado." << endl;
+        liberarMapeo(vista.archivo);
+        return false;
+    }
+
+    vista.width = info.width;
+    vista.height = info.height;
+    vista.bytesPorPixel = info.bytesPorPixel;
+    if (info.deArribaAbajo) {
+        vista.primeraFila = d + info.inicioPixeles;
+        vista.paso = (ptrdiff_t)info.bytesFila;
+    } else {
+        vista.primeraFila = d + info.inicioPixeles + info.bytesFila * (size_t)(info.height - 1);
+        vista.paso = -(ptrdiff_t)info.bytesFila;
     }
+    return true;
+}
 
-    out.close();
-    delete[] mask;
-    cout << "M1.txt corregido generado correctamente desde P2.bmp y M.bmp.\n" << endl;
+void cerrarVistaBMP(VistaBMP &vista) {
+    liberarMapeo(vista.archivo);
+    vista.primeraFila = nullptr;
 }
 
-void generarM2DesdeP1(unsigned char* p1, int offset, int n_pixels) {
-    int wM = 0, hM = 0;
-    unsigned char* mask = loadPixels("M.bmp", wM, hM);
+// Convierte una fila de BGR o BGRA (bytesPorPixel = 3 o 4) a RGB sin relleno. También sirve para
+// el sentido contrario (RGB a BGR), porque intercambiar R y B es su propia inversa.
+typedef void (*KernelFilaBGR)(const unsigned char*, unsigned char*, int, int);
 
-    if (mask == nullptr) {
-        cout << "No se pudo cargar la máscara M.bmp" << endl;
-        return;
+static void convertirFilaBGR_Escalar(const unsigned char* src, unsigned char* dst, int width, int bytesPorPixel) {
+    for (int x = 0; x < width; ++x) {
+        unsigned char b = src[0];
+        unsigned char g = src[1];
+        unsigned char r = src[2];
+        dst[0] = r;
+        dst[1] = g;
+        dst[2] = b;
+        src += bytesPorPixel;
+        dst += 3;
     }
+}
 
-    ofstream out("M2.txt");
-    if (!out.is_open()) {
-        cout << "Error al crear M2.txt" << endl;
-        delete[] mask;
-        return;
+#ifdef DESAFIO_X86
+OBJETIVO_CPU("ssse3")
+static void convertirFilaBGR_SSSE3(const unsigned char* src, unsigned char* dst, int width, int bytesPorPixel) {
+    int x = 0;
+    // Cada iteración lee y escribe 16 bytes, pero solo avanza los píxeles completos que contienen;
+    // se exige un margen de 6 píxeles para no salirse de la fila ni en la entrada ni en la salida.
+    if (bytesPorPixel == 3) {
+        const __m128i orden = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+        for (; x + 6 <= width; x += 5) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + x * 3));
+            _mm_storeu_si128((__m128i*)(dst + x * 3), _mm_shuffle_epi8(v, orden));
+        }
+    } else {
+        const __m128i orden = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        for (; x + 6 <= width; x += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + x * 4));
+            _mm_storeu_si128((__m128i*)(dst + x * 3), _mm_shuffle_epi8(v, orden));
+        }
     }
+    convertirFilaBGR_Escalar(src + x * bytesPorPixel, dst + x * 3, width - x, bytesPorPixel);
+}
+#endif
 
-    out << offset << endl;
+static KernelFilaBGR seleccionarKernelFilaBGR() {
+#ifdef DESAFIO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3")) return convertirFilaBGR_SSSE3;
+#endif
+    return convertirFilaBGR_Escalar;
+}
 
-    for (int i = 0; i < n_pixels * 3; i += 3) {
-        int r = p1[offset * 3 + i] + mask[i];
-        int g = p1[offset * 3 + i + 1] + mask[i + 1];
-        int b = p1[offset * 3 + i + 2] + mask[i + 2];
-        out << r << " " << g << " " << b << endl;
-    }
+static const KernelFilaBGR kernelFilaBGR = seleccionarKernelFilaBGR();
 
-    out.close();
-    delete[] mask;
-    cout << "M2.txt generado correctamente desde P1.bmp y M.bmp.\n" << endl;
+// fseek con desplazamientos de 64 bits (los BMP grandes superan los 2 GiB de un long en Windows)
+static bool posicionarArchivo(FILE* archivo, long long posicion) {
+#ifdef _WIN32
+    return _fseeki64(archivo, posicion, SEEK_SET) == 0;
+#else
+    return fseeko(archivo, (off_t)posicion, SEEK_SET) == 0;
+#endif
 }
 
-bool compararImagenes(QString archivo1, QString archivo2) {
-    QImage img1(archivo1);
-    QImage img2(archivo2);
-    if (img1.size() != img2.size()) return false;
-    img1 = img1.convertToFormat(QImage::Format_RGB888);
-    img2 = img2.convertToFormat(QImage::Format_RGB888);
+bool abrirLectorBMP(const char* ruta, LectorBMP &lector) {
+    lector.buffer = nullptr;
+    lector.capacidadFilas = 0;
+    lector.archivo = fopen(ruta, "rb");
+    if (lector.archivo == nullptr) return false;
 
-    for (int y = 0; y < img1.height(); ++y) {
-        const uchar* line1 = img1.scanLine(y);
-        const uchar* line2 = img2.scanLine(y);
-        if (memcmp(line1, line2, img1.width() * 3) != 0) return false;
+    unsigned char cabecera[54];
+    InfoBMP info;
+    if (fread(cabecera, 1, sizeof(cabecera), lector.archivo) != sizeof(cabecera) ||
+        !analizarCabeceraBMP(cabecera, info)) {
+        fclose(lector.archivo);
+        lector.archivo = nullptr;
+        return false;
     }
+    lector.width = info.width;
+    lector.height = info.height;
+    lector.bytesPorPixel = info.bytesPorPixel;
+    lector.deArribaAbajo = info.deArribaAbajo;
+    lector.bytesFila = info.bytesFila;
+    lector.inicioPixeles = info.inicioPixeles;
     return true;
 }
 
-bool compararArchivos(const char* archivo1, const char* archivo2) {
-    ifstream file1(archivo1);
-    ifstream file2(archivo2);
-    if (!file1.is_open() || !file2.is_open()) return false;
+// Lee las filas [primeraFila, primeraFila + nFilas) (0 = fila superior) y las deja en rgb, seguidas
+// y sin relleno. Las filas de una franja son contiguas en el archivo, así que basta una lectura.
+bool leerFilasBMP(LectorBMP &lector, int primeraFila, int nFilas, unsigned char* rgb) {
+    if (lector.archivo == nullptr || primeraFila < 0 || nFilas < 0 || primeraFila + nFilas > lector.height) {
+        return false;
+    }
+    if ((size_t)nFilas > lector.capacidadFilas) {
+        liberarBufferPixeles(lector.buffer);
+        lector.buffer = reservarBufferPixeles((size_t)nFilas * lector.bytesFila);
+        lector.capacidadFilas = (size_t)nFilas;
+    }
+
+    // Índice en el archivo de la fila de la franja que aparece primero
+    int primeraEnArchivo = lector.deArribaAbajo ? primeraFila : lector.height - primeraFila - nFilas;
+    long long posicion = (long long)lector.inicioPixeles + (long long)primeraEnArchivo * (long long)lector.bytesFila;
+    size_t bytes = (size_t)nFilas * lector.bytesFila;
+    if (!posicionarArchivo(lector.archivo, posicion) || fread(lector.buffer, 1, bytes, lector.archivo) != bytes) {
+        cout << "Error: no se pudieron leer las filas del archivo BMP." << endl;
+        return false;
+    }
 
-    string line1, line2;
-    while (getline(file1, line1) && getline(file2, line2)) {
-        if (line1 != line2) return false;
+    size_t bytesRGB = (size_t)lector.width * 3;
+    for (int k = 0; k < nFilas; ++k) {
+        // En los BMP de abajo hacia arriba la franja está invertida en el archivo
+        int enArchivo = lector.deArribaAbajo ? k : nFilas - 1 - k;
+        kernelFilaBGR(lector.buffer + (size_t)enArchivo * lector.bytesFila, rgb + (size_t)k * bytesRGB,
+                      lector.width, lector.bytesPorPixel);
     }
-    return file1.eof() && file2.eof();
+    return true;
+}
+
+void cerrarLectorBMP(LectorBMP &lector) {
+    if (lector.archivo != nullptr) fclose(lector.archivo);
+    lector.archivo = nullptr;
+    liberarBufferPixeles(lector.buffer);
+    lector.buffer = nullptr;
+    lector.capacidadFilas = 0;
+}
+
+bool tamanoImagenRGB(int width, int height, size_t &bytes) {
+    if (width <= 0 || height <= 0) return false;
+    size_t bytesFila = (size_t)width * 3;
+    if (bytesFila / 3 != (size_t)width || (size_t)height > SIZE_MAX / bytesFila) return false;
+    bytes = bytesFila * (size_t)height;
+    return true;
 }
 
+// Carga con el lector nativo; devuelve nullptr si el archivo no es un BMP de 24/32 bits sin comprimir
+static unsigned char* loadPixelsNativo(const char* ruta, int &width, int &height) {
+    VistaBMP vista;
+    if (!abrirVistaBMP(ruta, vista)) return nullptr;
 
+    size_t dataSize = 0;
+    if (!tamanoImagenRGB(vista.width, vista.height, dataSize)) {
+        cout << "Error: la imagen es demasiado grande para cargarla en memoria." << endl;
+        cerrarVistaBMP(vista);
+        return nullptr;
+    }
+    width = vista.width;
+    height = vista.height;
+    size_t bytesFila = (size_t)width * 3;
+    unsigned char* pixelData = reservarBufferPixeles(dataSize);
+    for (int y = 0; y < height; ++y) {
+        kernelFilaBGR(vista.primeraFila + (ptrdiff_t)y * vista.paso, pixelData + (size_t)y * bytesFila, width,
+                      vista.bytesPorPixel);
+    }
 
+    cerrarVistaBMP(vista);
+    return pixelData;
+}
 
+unsigned char* loadPixels(QString input, int &width, int &height){
+    /*
+ * @brief Carga una imagen BMP desde un archivo y extrae los datos de píxeles en formato RGB.
+ *
+ * Los BMP sin comprimir de 24 y 32 bits se leen directamente del archivo proyectado en memoria,
+ * convirtiendo cada fila de BGR a RGB en una sola pasada. Para cualquier otro formato se utiliza la
+ * clase QImage de Qt para abrir la imagen, convertirla al formato RGB888 (24 bits: 8 bits por canal),
+ * y copiar sus datos de píxeles a un arreglo dinámico de tipo unsigned char. El arreglo contendrá los valores de los canales Rojo, Verde y Azul (R, G, B)
+ * de cada píxel de la imagen, sin rellenos (padding).
+ *
+ * @param input Ruta del archivo de imagen BMP a cargar (tipo QString).
+ * @param width Parámetro de salida que contendrá el ancho de la imagen cargada (en píxeles).
+ * @param height Parámetro de salida que contendrá la altura de la imagen cargada (en píxeles).
+ * @return Puntero a un arreglo dinámico que contiene los datos de los píxeles en formato RGB.
+ *         Devuelve nullptr si la imagen no pudo cargarse.
+ *
+ * @note Es responsabilidad del usuario liberar el arreglo devuelto con `liberarBufferPixeles()`.
+ */
+    SpanTraza traza("loadPixels");
+
+    // Intentar primero el lector nativo (BMP de 24/32 bits sin comprimir)
+    unsigned char* nativo = loadPixelsNativo(input.toLocal8Bit().constData(), width, height);
+    if (nativo != nullptr) {
+        traza.bytes = (size_t)width * height * 3;
+        return nativo;
+    }
+
+    // Cargar la imagen BMP desde el archivo especificado (usando Qt)
+    QImage imagen(input);
+
+    // Verifica si la imagen fue cargada correctamente
+    if (imagen.isNull()) {
+        cout << "Error: No se pudo cargar la imagen BMP." << std::endl;
+        return nullptr; // Retorna un puntero nulo si la carga falló
+    }
+
+    // Convierte la imagen al formato RGB888 (3 canales de 8 bits sin transparencia)
+    imagen = imagen.convertToFormat(QImage::Format_RGB888);
+
+    // Obtiene el ancho y el alto de la imagen cargada
+    width = imagen.width();
+    height = imagen.height();
+
+    // Calcula el tamaño total de datos (3 bytes por píxel: R, G, B)
+    size_t dataSize = 0;
+    if (!tamanoImagenRGB(width, height, dataSize)) {
+        cout << "Error: la imagen es demasiado grande para cargarla en memoria." << endl;
+        return nullptr;
+    }
+
+    // Reserva memoria para almacenar los valores RGB de cada píxel (un buffer reciclable del pool)
+    unsigned char* pixelData = reservarBufferPixeles(dataSize);
+
+    // Copia cada línea de píxeles de la imagen Qt a nuestro arreglo lineal
+    for (int y = 0; y < height; ++y) {
+        const uchar* srcLine = imagen.scanLine(y);                // Línea original de la imagen con posible padding
+        unsigned char* dstLine = pixelData + (size_t)y * width * 3; // Línea destino en el arreglo lineal sin padding
+        memcpy(dstLine, srcLine, (size_t)width * 3);                // Copia los píxeles RGB de esa línea (sin padding)
+    }
+
+    // Retorna el puntero al arreglo de datos de píxeles cargado en memoria
+    traza.bytes = dataSize;
+    return pixelData;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Registro de imágenes en memoria
+//
+// Cada archivo se decodifica a lo sumo una vez por ejecución: la entrada se identifica por ruta,
+// tamaño y fecha de modificación, y todos los que la pidan reciben el mismo buffer de solo
+// lectura. Si el archivo cambia en disco la entrada vieja queda retirada (su buffer sigue siendo
+// válido para quien ya lo tenga) y se decodifica de nuevo. Los buffers se liberan todos juntos en
+// liberarCacheImagenes().
+// ---------------------------------------------------------------------------------------------
+
+struct EntradaCacheImagen {
+    string ruta;
+    long long tamanoArchivo;
+    long long fechaModificacion;   // En nanosegundos cuando el sistema lo permite
+    unsigned char* datos;
+    int width;
+    int height;
+    bool retirada;
+};
+
+static EntradaCacheImagen* cacheImagenes = nullptr;
+static int n_imagenesCache = 0;
+static int capacidadCacheImagenes = 0;
+static mutex mutexCacheImagenes;
+
+// Tamaño y fecha de modificación del archivo; false si no existe
+static bool firmaArchivo(const char* ruta, long long &tamano, long long &fecha) {
+#ifdef _WIN32
+    struct __stat64 info;
+    if (_stat64(ruta, &info) != 0) return false;
+    fecha = (long long)info.st_mtime * 1000000000LL;
+#else
+    struct stat info;
+    if (stat(ruta, &info) != 0) return false;
+#ifdef __APPLE__
+    fecha = (long long)info.st_mtimespec.tv_sec * 1000000000LL + info.st_mtimespec.tv_nsec;
+#else
+    fecha = (long long)info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+#endif
+#endif
+    tamano = (long long)info.st_size;
+    return true;
+}
+
+// Agrega una entrada retirando las anteriores de la misma ruta. Se llama con el mutex tomado.
+static void agregarEntradaCache(const char* ruta, long long tamano, long long fecha,
+                                unsigned char* datos, int width, int height) {
+    for (int i = 0; i < n_imagenesCache; ++i) {
+        if (cacheImagenes[i].ruta == ruta) cacheImagenes[i].retirada = true;
+    }
+    if (n_imagenesCache == capacidadCacheImagenes) {
+        int nuevaCapacidad = capacidadCacheImagenes == 0 ? 8 : capacidadCacheImagenes * 2;
+        EntradaCacheImagen* nuevas = new EntradaCacheImagen[nuevaCapacidad];
+        for (int i = 0; i < n_imagenesCache; ++i) nuevas[i] = cacheImagenes[i];
+        delete[] cacheImagenes;
+        cacheImagenes = nuevas;
+        capacidadCacheImagenes = nuevaCapacidad;
+    }
+    EntradaCacheImagen &entrada = cacheImagenes[n_imagenesCache++];
+    entrada.ruta = ruta;
+    entrada.tamanoArchivo = tamano;
+    entrada.fechaModificacion = fecha;
+    entrada.datos = datos;
+    entrada.width = width;
+    entrada.height = height;
+    entrada.retirada = false;
+}
+
+const unsigned char* obtenerImagenCacheada(const char* ruta, int &width, int &height) {
+    /*
+ * @brief Devuelve los píxeles RGB de una imagen, decodificándola solo si no está en el registro.
+ *
+ * @param ruta Ruta del archivo BMP.
+ * @param width Parámetro de salida con el ancho de la imagen.
+ * @param height Parámetro de salida con el alto de la imagen.
+ * @return Puntero de solo lectura a los datos RGB (width * height * 3 bytes), o nullptr si la
+ *         imagen no pudo cargarse.
+ *
+ * @note El buffer pertenece al registro: no se debe liberar con liberarBufferPixeles().
+ */
+    lock_guard<mutex> candado(mutexCacheImagenes);
+
+    long long tamano = 0, fecha = 0;
+    bool existe = firmaArchivo(ruta, tamano, fecha);
+    if (existe) {
+        for (int i = 0; i < n_imagenesCache; ++i) {
+            const EntradaCacheImagen &entrada = cacheImagenes[i];
+            if (!entrada.retirada && entrada.tamanoArchivo == tamano &&
+                entrada.fechaModificacion == fecha && entrada.ruta == ruta) {
+                width = entrada.width;
+                height = entrada.height;
+                return entrada.datos;
+            }
+        }
+    }
+
+    unsigned char* datos = loadPixels(QString(ruta), width, height);
+    if (datos == nullptr) return nullptr;
+    agregarEntradaCache(ruta, tamano, fecha, datos, width, height);
+    return datos;
+}
+
+void liberarCacheImagenes() {
+    lock_guard<mutex> candado(mutexCacheImagenes);
+    for (int i = 0; i < n_imagenesCache; ++i) {
+        liberarBufferPixeles(cacheImagenes[i].datos);
+    }
+    delete[] cacheImagenes;
+    cacheImagenes = nullptr;
+    n_imagenesCache = 0;
+    capacidadCacheImagenes = 0;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Escritura nativa de BMP
+// ---------------------------------------------------------------------------------------------
+
+// Tamaño del buffer intermedio del escritor: suficiente para que cada fwrite sea grande
+const size_t TAMANO_BUFFER_ESCRITURA = 4 * 1024 * 1024;
+
+static void escribirU16(unsigned char* p, unsigned int v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void escribirU32(unsigned char* p, unsigned int v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+bool abrirEscritorBMP(const char* ruta, int width, int height, EscritorBMP &escritor) {
+    escritor.archivo = nullptr;
+    escritor.buffer = nullptr;
+    escritor.error = false;
+    size_t dataSize = 0;
+    if (!tamanoImagenRGB(width, height, dataSize)) return false;
+
+    escritor.width = width;
+    escritor.height = height;
+    escritor.bytesFila = (((size_t)width * 3) + 3) & ~(size_t)3;
+
+    escritor.archivo = fopen(ruta, "wb");
+    if (escritor.archivo == nullptr) return false;
+    // El buffer propio ya agrupa las escrituras; el de stdio solo añadiría una copia más
+    setvbuf(escritor.archivo, nullptr, _IONBF, 0);
+
+    size_t tamanoImagen = escritor.bytesFila * (size_t)height;
+    unsigned char cabecera[54];
+    memset(cabecera, 0, sizeof(cabecera));
+    // BITMAPFILEHEADER
+    cabecera[0] = 'B';
+    cabecera[1] = 'M';
+    // Los campos de tamaño son de 32 bits: en imágenes de más de 4 GiB se dejan en 0, que los lectores
+    // de BI_RGB aceptan (el tamaño se deduce del ancho y el alto)
+    bool tamanoCabe = tamanoImagen <= 0xFFFFFFFFu - sizeof(cabecera);
+    escribirU32(cabecera + 2, tamanoCabe ? (unsigned int)(sizeof(cabecera) + tamanoImagen) : 0);
+    escribirU32(cabecera + 10, sizeof(cabecera));
+    // BITMAPINFOHEADER: 24 bits, sin compresión, 96 ppp (el valor por defecto de QImage)
+    escribirU32(cabecera + 14, 40);
+    escribirU32(cabecera + 18, (unsigned int)width);
+    escribirU32(cabecera + 22, (unsigned int)height);
+    escribirU16(cabecera + 26, 1);
+    escribirU16(cabecera + 28, 24);
+    escribirU32(cabecera + 34, tamanoCabe ? (unsigned int)tamanoImagen : 0);
+    escribirU32(cabecera + 38, 3780);
+    escribirU32(cabecera + 42, 3780);
+    if (fwrite(cabecera, 1, sizeof(cabecera), escritor.archivo) != sizeof(cabecera)) {
+        fclose(escritor.archivo);
+        escritor.archivo = nullptr;
+        return false;
+    }
+
+    escritor.capacidadFilas = TAMANO_BUFFER_ESCRITURA / escritor.bytesFila;
+    if (escritor.capacidadFilas == 0) escritor.capacidadFilas = 1;
+    if (escritor.capacidadFilas > (size_t)height) escritor.capacidadFilas = (size_t)height;
+    escritor.buffer = reservarBufferPixeles(escritor.capacidadFilas * escritor.bytesFila);
+    return true;
+}
+
+// Escribe las filas [primeraFila, primeraFila + nFilas) de la imagen (0 = fila superior), tomadas
+// de rgb, que contiene esas filas seguidas y sin relleno. Las franjas pueden llegar en cualquier
+// orden; si llegan de abajo hacia arriba el archivo se escribe de forma secuencial.
+bool escribirFilasBMP(EscritorBMP &escritor, const unsigned char* rgb, int primeraFila, int nFilas) {
+    if (escritor.archivo == nullptr || escritor.error) return false;
+    if (primeraFila < 0 || nFilas < 0 || primeraFila + nFilas > escritor.height) return false;
+
+    size_t bytesRGB = (size_t)escritor.width * 3;
+    size_t relleno = escritor.bytesFila - bytesRGB;
+
+    // En el archivo la fila y ocupa la posición height - 1 - y: se recorre la franja desde su última
+    // fila para llenar el buffer en el orden del archivo.
+    int y = primeraFila + nFilas - 1;
+    while (y >= primeraFila) {
+        size_t filasBloque = (size_t)(y - primeraFila + 1);
+        if (filasBloque > escritor.capacidadFilas) filasBloque = escritor.capacidadFilas;
+
+        long long posicion = 54 + (long long)(escritor.height - 1 - y) * (long long)escritor.bytesFila;
+        unsigned char* destino = escritor.buffer;
+        for (size_t k = 0; k < filasBloque; ++k, --y) {
+            kernelFilaBGR(rgb + (size_t)(y - primeraFila) * bytesRGB, destino, escritor.width, 3);
+            if (relleno > 0) memset(destino + bytesRGB, 0, relleno);
+            destino += escritor.bytesFila;
+        }
+
+        size_t bytesBloque = filasBloque * escritor.bytesFila;
+        if (!posicionarArchivo(escritor.archivo, posicion) ||
+            fwrite(escritor.buffer, 1, bytesBloque, escritor.archivo) != bytesBloque) {
+            escritor.error = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool cerrarEscritorBMP(EscritorBMP &escritor) {
+    bool ok = escritor.archivo != nullptr && !escritor.error;
+    if (escritor.archivo != nullptr && fclose(escritor.archivo) != 0) ok = false;
+    escritor.archivo = nullptr;
+    liberarBufferPixeles(escritor.buffer);
+    escritor.buffer = nullptr;
+    return ok;
+}
+
+bool exportImage(const unsigned char* pixelData, int width,int height, QString archivoSalida){
+    /*
+ * @brief Exporta una imagen en formato BMP a partir de un arreglo de píxeles en formato RGB.
+ *
+ * Esta función escribe directamente la cabecera BMP y, a continuación, las filas del arreglo dinámico
+ * `pixelData`, que debe representar una imagen en formato RGB888 (3 bytes por píxel, sin padding).
+ * Cada fila se convierte a BGR y se rellena hasta un múltiplo de 4 bytes en un buffer intermedio que
+ * se vuelca al archivo en bloques grandes, sin crear un QImage.
+ *
+ * @param pixelData Puntero a un arreglo de bytes que contiene los datos RGB de la imagen a exportar.
+ *                  El tamaño debe ser igual a width * height * 3 bytes.
+ * @param width Ancho de la imagen en píxeles.
+ * @param height Alto de la imagen en píxeles.
+ * @param archivoSalida Ruta y nombre del archivo de salida en el que se guardará la imagen BMP (QString).
+ *
+ * @return true si la imagen se guardó exitosamente; false si ocurrió un error durante el proceso.
+ *
+ * @note La función no libera la memoria del arreglo pixelData; esta responsabilidad recae en el usuario.
+ */
+    SpanTraza traza("exportImage", (size_t)width * height * 3);
+
+    // Escribir la cabecera y luego todas las filas, convertidas a BGR y con su relleno, a través
+    // del buffer del escritor (sin copiar la imagen completa a un QImage)
+    EscritorBMP escritor;
+    bool guardada = abrirEscritorBMP(archivoSalida.toLocal8Bit().constData(), width, height, escritor);
+    if (guardada) {
+        guardada = escribirFilasBMP(escritor, pixelData, 0, height);
+    }
+    guardada = cerrarEscritorBMP(escritor) && guardada;
+
+    // Informar el resultado de la escritura
+    if (!guardada) {
+        // Si hubo un error al guardar, mostrar mensaje de error
+        cout << "Error: No se pudo guardar la imagen BMP modificada.";
+        return false; // Indica que la operación falló
+    } else {
+        // Si la imagen fue guardada correctamente, mostrar mensaje de éxito
+        cout << "Imagen BMP modificada guardada como " << archivoSalida.toStdString() << endl;
+        return true; // Indica éxito
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+// Trazas por etapa
+//
+// Cada hilo escribe sus eventos en su propio BufferTraza, así que registrar un evento no necesita
+// cerrojos: el hilo dueño guarda el evento y después publica el contador con memory_order_release.
+// Los buffers se enlazan en una lista global (inserción con compare_exchange) que recorre el
+// volcado, y no se liberan nunca para que sigan siendo válidos aunque el hilo ya haya terminado.
+// ---------------------------------------------------------------------------------------------
+
+const int CAPACIDAD_TRAZA = 1 << 14;   // Eventos por hilo; al llenarse se pisan los más viejos
+
+struct EventoTraza {
+    const char* nombre;
+    unsigned long long inicioNs;
+    unsigned long long finNs;
+    size_t bytes;
+};
+
+struct BufferTraza {
+    EventoTraza eventos[CAPACIDAD_TRAZA];
+    atomic<unsigned long long> escritos;
+    int hilo;
+    BufferTraza* siguiente;
+};
+
+atomic<bool> trazasActivas(false);
+static unsigned long long origenTrazaNs = 0;
+static const char* archivoTrazas = nullptr;
+static atomic<BufferTraza*> buffersTraza(nullptr);
+static atomic<int> hilosTraza(0);
+static thread_local BufferTraza* bufferTrazaHilo = nullptr;
+
+unsigned long long relojTrazaNs() {
+    return (unsigned long long)chrono::duration_cast<chrono::nanoseconds>(
+               chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static BufferTraza* bufferTrazaDelHilo() {
+    if (bufferTrazaHilo == nullptr) {
+        BufferTraza* buffer = new BufferTraza;
+        buffer->escritos.store(0, memory_order_relaxed);
+        buffer->hilo = hilosTraza.fetch_add(1, memory_order_relaxed) + 1;
+        buffer->siguiente = buffersTraza.load(memory_order_relaxed);
+        while (!buffersTraza.compare_exchange_weak(buffer->siguiente, buffer, memory_order_release,
+                                                   memory_order_relaxed)) {
+        }
+        bufferTrazaHilo = buffer;
+    }
+    return bufferTrazaHilo;
+}
+
+void registrarEventoTraza(const char* nombre, unsigned long long inicioNs, unsigned long long finNs, size_t bytes) {
+    BufferTraza* buffer = bufferTrazaDelHilo();
+    unsigned long long n = buffer->escritos.load(memory_order_relaxed);
+    EventoTraza &evento = buffer->eventos[n % CAPACIDAD_TRAZA];
+    evento.nombre = nombre;
+    evento.inicioNs = inicioNs;
+    evento.finNs = finNs;
+    evento.bytes = bytes;
+    buffer->escritos.store(n + 1, memory_order_release);
+}
+
+static void volcarTrazasAlSalir() {
+    trazasActivas.store(false, memory_order_relaxed);
+    if (archivoTrazas != nullptr) escribirTrazas(archivoTrazas);
+}
+
+void activarTrazas(const char* archivoSalida) {
+    if (archivoTrazas == nullptr) atexit(volcarTrazasAlSalir);
+    archivoTrazas = archivoSalida;
+    origenTrazaNs = relojTrazaNs();
+    bufferTrazaDelHilo();   // El hilo que activa las trazas queda como el hilo 1 ("principal")
+    trazasActivas.store(true, memory_order_relaxed);
+}
+
+bool escribirTrazas(const char* archivoSalida) {
+    /*
+ * @brief Escribe los eventos registrados como JSON de Chrome trace-event.
+ *
+ * Cada SpanTraza es un evento completo ("ph":"X") con ts y dur en microsegundos desde que se
+ * activaron las trazas, tid igual al número de hilo y args.bytes con los bytes procesados (más el
+ * rendimiento en MB/s si el span duró algo). Si un hilo registró más de CAPACIDAD_TRAZA eventos
+ * solo se conservan los últimos. Debe llamarse cuando ningún otro hilo esté registrando.
+ *
+ * @return true si el archivo se escribió completo.
+ */
+    FILE* out = fopen(archivoSalida, "wb");
+    if (out == nullptr) {
+        cout << "Error: no se pudo crear el archivo de trazas " << archivoSalida << endl;
+        return false;
+    }
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool primero = true;
+    unsigned long long total = 0;
+    for (BufferTraza* buffer = buffersTraza.load(memory_order_acquire); buffer != nullptr; buffer = buffer->siguiente) {
+        unsigned long long n = buffer->escritos.load(memory_order_acquire);
+        unsigned long long desde = n > (unsigned long long)CAPACIDAD_TRAZA ? n - CAPACIDAD_TRAZA : 0;
+
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}",
+                primero ? "" : ",\n", buffer->hilo, buffer->hilo == 1 ? "principal" : "hilo", buffer->hilo);
+        primero = false;
+
+        for (unsigned long long i = desde; i < n; ++i) {
+            const EventoTraza &e = buffer->eventos[i % CAPACIDAD_TRAZA];
+            unsigned long long inicio = e.inicioNs > origenTrazaNs ? e.inicioNs - origenTrazaNs : 0;
+            unsigned long long duracion = e.finNs - e.inicioNs;
+            fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                         "\"args\":{\"bytes\":%llu",
+                    e.nombre, buffer->hilo, inicio / 1000.0, duracion / 1000.0, (unsigned long long)e.bytes);
+            if (e.bytes != 0 && duracion != 0) fprintf(out, ",\"MB/s\":%.1f", e.bytes * 1000.0 / duracion);
+            fprintf(out, "}}");
+        }
+        total += n - desde;
+    }
+    fprintf(out, "\n]}\n");
+
+    bool ok = ferror(out) == 0;
+    ok = fclose(out) == 0 && ok;
+    if (ok) {
+        cout << "Trazas guardadas en " << archivoSalida << " (" << total << " eventos)" << endl;
+    } else {
+        cout << "Error: no se pudo escribir el archivo de trazas " << archivoSalida << endl;
+    }
+    return ok;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Pool de hilos
+// ---------------------------------------------------------------------------------------------
+
+// Los hilos se crean la primera vez que hace falta y duermen entre trabajos; cada trabajo nuevo
+// se publica incrementando generacion.
+struct PoolHilos {
+    thread* hilos;
+    int n_hilos;                       // Trabajadores; el hilo que llama es la parte 0
+    mutex uso;                         // Un solo trabajo paralelo a la vez
+    mutex estado;
+    condition_variable hayTrabajo;
+    condition_variable terminado;
+    unsigned long long generacion;
+    bool cerrando;
+    TareaRango tarea;
+    void* contexto;
+    size_t total;
+    size_t porParte;
+    int pendientes;
+
+    PoolHilos();
+    ~PoolHilos();
+};
+
+// Evita que una tarea que ya corre dentro del pool vuelva a pedirlo (se quedaría esperando)
+static thread_local bool dentroDelPool = false;
+
+static void trabajadorPool(PoolHilos* pool, int parte) {
+    dentroDelPool = true;
+    unsigned long long vista = 0;
+    while (true) {
+        unique_lock<mutex> cerrojo(pool->estado);
+        pool->hayTrabajo.wait(cerrojo, [&]() { return pool->cerrando || pool->generacion != vista; });
+        if (pool->cerrando) return;
+        vista = pool->generacion;
+        TareaRango tarea = pool->tarea;
+        void* contexto = pool->contexto;
+        size_t desde = pool->porParte * parte;
+        size_t hasta = desde + pool->porParte < pool->total ? desde + pool->porParte : pool->total;
+        cerrojo.unlock();
+
+        if (desde < hasta) {
+            SpanTraza traza("parte paralela", hasta - desde);
+            tarea(contexto, desde, hasta);
+        }
+
+        cerrojo.lock();
+        if (--pool->pendientes == 0) pool->terminado.notify_one();
+    }
+}
+
+PoolHilos::PoolHilos() : generacion(0), cerrando(false), tarea(nullptr), contexto(nullptr), total(0),
+                         porParte(0), pendientes(0) {
+    n_hilos = (int)thread::hardware_concurrency() - 1;
+    if (n_hilos < 0) n_hilos = 0;
+    hilos = new thread[n_hilos > 0 ? n_hilos : 1];
+    for (int h = 0; h < n_hilos; ++h) hilos[h] = thread(trabajadorPool, this, h + 1);
+}
+
+PoolHilos::~PoolHilos() {
+    {
+        lock_guard<mutex> cerrojo(estado);
+        cerrando = true;
+    }
+    hayTrabajo.notify_all();
+    for (int h = 0; h < n_hilos; ++h) hilos[h].join();
+    delete[] hilos;
+}
+
+static PoolHilos &poolHilos() {
+    static PoolHilos pool;
+    return pool;
+}
+
+void ejecutarEnParalelo(TareaRango tarea, void* contexto, size_t total, size_t minimo, size_t granularidad) {
+    if (total == 0) return;
+    if (total < minimo || dentroDelPool) {
+        tarea(contexto, 0, total);
+        return;
+    }
+    PoolHilos &pool = poolHilos();
+    if (pool.n_hilos == 0 || !pool.uso.try_lock()) {
+        tarea(contexto, 0, total);
+        return;
+    }
+
+    if (granularidad == 0) granularidad = 1;
+    size_t partes = (size_t)pool.n_hilos + 1;
+    size_t porParte = (total + partes - 1) / partes;
+    porParte = (porParte + granularidad - 1) / granularidad * granularidad;
+    {
+        lock_guard<mutex> cerrojo(pool.estado);
+        pool.tarea = tarea;
+        pool.contexto = contexto;
+        pool.total = total;
+        pool.porParte = porParte;
+        pool.pendientes = pool.n_hilos;
+        ++pool.generacion;
+    }
+    pool.hayTrabajo.notify_all();
+
+    dentroDelPool = true;
+    {
+        SpanTraza traza("parte paralela", porParte < total ? porParte : total);
+        tarea(contexto, 0, porParte < total ? porParte : total);
+    }
+    dentroDelPool = false;
+
+    {
+        unique_lock<mutex> cerrojo(pool.estado);
+        pool.terminado.wait(cerrojo, [&]() { return pool.pendientes == 0; });
+    }
+    pool.uso.unlock();
+}
+
+// Variantes del XOR. Todas calculan result[i] = img1[i] ^ img2[i] sobre dataSize bytes y
+// admiten que result coincida con img1 o img2 (XOR en el mismo lugar).
+typedef void (*KernelXOR)(const unsigned char*, const unsigned char*, unsigned char*, size_t);
+
+static void applyXOR_Escalar(const unsigned char* img1, const unsigned char* img2, unsigned char* result, size_t dataSize) {
+    for (size_t i = 0; i < dataSize; ++i) {
+        result[i] = img1[i] ^ img2[i];
+    }
+}
+
+#ifdef DESAFIO_X86
+OBJETIVO_CPU("sse2")
+static void applyXOR_SSE2(const unsigned char* img1, const unsigned char* img2, unsigned char* result, size_t dataSize) {
+    size_t i = 0;
+    // Bloques de 64 bytes (4 registros) para mantener varias cargas en vuelo
+    for (; i + 64 <= dataSize; i += 64) {
+        __m128i a0 = _mm_loadu_si128((const __m128i*)(img1 + i));
+        __m128i a1 = _mm_loadu_si128((const __m128i*)(img1 + i + 16));
+        __m128i a2 = _mm_loadu_si128((const __m128i*)(img1 + i + 32));
+        __m128i a3 = _mm_loadu_si128((const __m128i*)(img1 + i + 48));
+        __m128i b0 = _mm_loadu_si128((const __m128i*)(img2 + i));
+        __m128i b1 = _mm_loadu_si128((const __m128i*)(img2 + i + 16));
+        __m128i b2 = _mm_loadu_si128((const __m128i*)(img2 + i + 32));
+        __m128i b3 = _mm_loadu_si128((const __m128i*)(img2 + i + 48));
+        _mm_storeu_si128((__m128i*)(result + i), _mm_xor_si128(a0, b0));
+        _mm_storeu_si128((__m128i*)(result + i + 16), _mm_xor_si128(a1, b1));
+        _mm_storeu_si128((__m128i*)(result + i + 32), _mm_xor_si128(a2, b2));
+        _mm_storeu_si128((__m128i*)(result + i + 48), _mm_xor_si128(a3, b3));
+    }
+    for (; i + 16 <= dataSize; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(img1 + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(img2 + i));
+        _mm_storeu_si128((__m128i*)(result + i), _mm_xor_si128(a, b));
+    }
+    // Cola de menos de 16 bytes
+    applyXOR_Escalar(img1 + i, img2 + i, result + i, dataSize - i);
+}
+
+OBJETIVO_CPU("avx2")
+static void applyXOR_AVX2(const unsigned char* img1, const unsigned char* img2, unsigned char* result, size_t dataSize) {
+    size_t i = 0;
+    for (; i + 128 <= dataSize; i += 128) {
+        __m256i a0 = _mm256_loadu_si256((const __m256i*)(img1 + i));
+        __m256i a1 = _mm256_loadu_si256((const __m256i*)(img1 + i + 32));
+        __m256i a2 = _mm256_loadu_si256((const __m256i*)(img1 + i + 64));
+        __m256i a3 = _mm256_loadu_si256((const __m256i*)(img1 + i + 96));
+        __m256i b0 = _mm256_loadu_si256((const __m256i*)(img2 + i));
+        __m256i b1 = _mm256_loadu_si256((const __m256i*)(img2 + i + 32));
+        __m256i b2 = _mm256_loadu_si256((const __m256i*)(img2 + i + 64));
+        __m256i b3 = _mm256_loadu_si256((const __m256i*)(img2 + i + 96));
+        _mm256_storeu_si256((__m256i*)(result + i), _mm256_xor_si256(a0, b0));
+        _mm256_storeu_si256((__m256i*)(result + i + 32), _mm256_xor_si256(a1, b1));
+        _mm256_storeu_si256((__m256i*)(result + i + 64), _mm256_xor_si256(a2, b2));
+        _mm256_storeu_si256((__m256i*)(result + i + 96), _mm256_xor_si256(a3, b3));
+    }
+    for (; i + 32 <= dataSize; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(img1 + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(img2 + i));
+        _mm256_storeu_si256((__m256i*)(result + i), _mm256_xor_si256(a, b));
+    }
+    // Evita la penalización de mezclar AVX y SSE antes de volver al código escalar
+    _mm256_zeroupper();
+    applyXOR_Escalar(img1 + i, img2 + i, result + i, dataSize - i);
+}
+
+OBJETIVO_CPU("avx512f,avx512bw")
+static void applyXOR_AVX512(const unsigned char* img1, const unsigned char* img2, unsigned char* result, size_t dataSize) {
+    size_t i = 0;
+    for (; i + 128 <= dataSize; i += 128) {
+        __m512i a0 = _mm512_loadu_si512((const void*)(img1 + i));
+        __m512i a1 = _mm512_loadu_si512((const void*)(img1 + i + 64));
+        __m512i b0 = _mm512_loadu_si512((const void*)(img2 + i));
+        __m512i b1 = _mm512_loadu_si512((const void*)(img2 + i + 64));
+        _mm512_storeu_si512((void*)(result + i), _mm512_xor_si512(a0, b0));
+        _mm512_storeu_si512((void*)(result + i + 64), _mm512_xor_si512(a1, b1));
+    }
+    for (; i + 64 <= dataSize; i += 64) {
+        __m512i a = _mm512_loadu_si512((const void*)(img1 + i));
+        __m512i b = _mm512_loadu_si512((const void*)(img2 + i));
+        _mm512_storeu_si512((void*)(result + i), _mm512_xor_si512(a, b));
+    }
+    // La cola se resuelve con una sola operación enmascarada (AVX-512BW) en lugar de un bucle escalar
+    if (i < dataSize) {
+        __mmask64 m = ~0ULL >> (64 - (dataSize - i));
+        __m512i a = _mm512_maskz_loadu_epi8(m, img1 + i);
+        __m512i b = _mm512_maskz_loadu_epi8(m, img2 + i);
+        _mm512_mask_storeu_epi8(result + i, m, _mm512_xor_si512(a, b));
+    }
+    _mm256_zeroupper();
+}
+#endif
+
+// Elige la mejor variante disponible consultando CPUID una sola vez, al arrancar el programa
+static KernelXOR seleccionarKernelXOR() {
+#ifdef DESAFIO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) return applyXOR_AVX512;
+    if (__builtin_cpu_supports("avx2")) return applyXOR_AVX2;
+    if (__builtin_cpu_supports("sse2")) return applyXOR_SSE2;
+#endif
+    return applyXOR_Escalar;
+}
+
+static const KernelXOR kernelXOR = seleccionarKernelXOR();
+
+struct ContextoXOR {
+    const unsigned char* img1;
+    const unsigned char* img2;
+    unsigned char* result;
+};
+
+static void tareaXOR(void* contexto, size_t desde, size_t hasta) {
+    const ContextoXOR* c = (const ContextoXOR*)contexto;
+    kernelXOR(c->img1 + desde, c->img2 + desde, c->result + desde, hasta - desde);
+}
+
+// Para aplicar el XOR (en paralelo en imágenes grandes)
+void applyXOR(const unsigned char* img1, const unsigned char* img2, unsigned char* result, size_t dataSize) {
+    SpanTraza traza("applyXOR", dataSize);
+    ContextoXOR contexto = {img1, img2, result};
+    ejecutarEnParalelo(tareaXOR, &contexto, dataSize);
+}
+// Variantes de la rotación. Todas rotan cada byte `bits` posiciones a la izquierda (0..7) y escriben
+// en dst, que puede ser el mismo arreglo que src. La rotación a la derecha por n equivale a rotar a
+// la izquierda por 8 - n, así que basta con un solo juego de kernels.
+typedef void (*KernelRotacion)(const unsigned char*, unsigned char*, size_t, int);
+
+// Variantes fusionadas de XOR y rotación, para recorrer los datos una sola vez:
+// - KernelXORRotacion: dst = rotl(a ^ b, bits); si intermedio no es nulo también guarda a ^ b.
+// - KernelRotacionXOR: dst = rotl(a, bits) ^ b.
+typedef void (*KernelXORRotacion)(const unsigned char*, const unsigned char*, unsigned char*, unsigned char*, size_t, int);
+typedef void (*KernelRotacionXOR)(const unsigned char*, const unsigned char*, unsigned char*, size_t, int);
+
+static inline unsigned char rotarByteIzquierda(unsigned char x, int bits) {
+    return (unsigned char)((x << bits) | (x >> (8 - bits)));
+}
+
+static void rotarIzquierda_Escalar(const unsigned char* src, unsigned char* dst, size_t dataSize, int bits) {
+    for (size_t i = 0; i < dataSize; ++i) {
+        dst[i] = rotarByteIzquierda(src[i], bits);
+    }
+}
+
+static void xorRotar_Escalar(const unsigned char* a, const unsigned char* b, unsigned char* intermedio,
+                             unsigned char* dst, size_t dataSize, int bits) {
+    for (size_t i = 0; i < dataSize; ++i) {
+        unsigned char x = a[i] ^ b[i];
+        if (intermedio != nullptr) intermedio[i] = x;
+        dst[i] = rotarByteIzquierda(x, bits);
+    }
+}
+
+static void rotarXor_Escalar(const unsigned char* a, const unsigned char* b, unsigned char* dst, size_t dataSize, int bits) {
+    for (size_t i = 0; i < dataSize; ++i) {
+        dst[i] = rotarByteIzquierda(a[i], bits) ^ b[i];
+    }
+}
+
+#ifdef DESAFIO_X86
+// x86 no tiene rotación de bytes: se desplazan palabras de 16 bits y se enmascaran los bits que
+// cruzan de un byte al vecino.
+struct RotacionSSE2 {
+    __m128i cuentaIzq, cuentaDer, mascaraIzq, mascaraDer;
+};
+
+OBJETIVO_CPU("sse2")
+static inline RotacionSSE2 prepararRotacionSSE2(int bits) {
+    RotacionSSE2 r;
+    r.cuentaIzq = _mm_cvtsi32_si128(bits);
+    r.cuentaDer = _mm_cvtsi32_si128(8 - bits);
+    r.mascaraIzq = _mm_set1_epi8((char)(0xFF << bits));
+    r.mascaraDer = _mm_set1_epi8((char)(0xFF >> (8 - bits)));
+    return r;
+}
+
+OBJETIVO_CPU("sse2")
+static inline __m128i rotarSSE2(__m128i x, const RotacionSSE2& r) {
+    return _mm_or_si128(_mm_and_si128(_mm_sll_epi16(x, r.cuentaIzq), r.mascaraIzq),
+                        _mm_and_si128(_mm_srl_epi16(x, r.cuentaDer), r.mascaraDer));
+}
+
+OBJETIVO_CPU("sse2")
+static void rotarIzquierda_SSE2(const unsigned char* src, unsigned char* dst, size_t dataSize, int bits) {
+    const RotacionSSE2 r = prepararRotacionSSE2(bits);
+    size_t i = 0;
+    for (; i + 16 <= dataSize; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), rotarSSE2(x, r));
+    }
+    rotarIzquierda_Escalar(src + i, dst + i, dataSize - i, bits);
+}
+
+OBJETIVO_CPU("sse2")
+static void xorRotar_SSE2(const unsigned char* a, const unsigned char* b, unsigned char* intermedio,
+                          unsigned char* dst, size_t dataSize, int bits) {
+    const RotacionSSE2 r = prepararRotacionSSE2(bits);
+    size_t i = 0;
+    for (; i + 16 <= dataSize; i += 16) {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i)));
+        if (intermedio != nullptr) _mm_storeu_si128((__m128i*)(intermedio + i), x);
+        _mm_storeu_si128((__m128i*)(dst + i), rotarSSE2(x, r));
+    }
+    xorRotar_Escalar(a + i, b + i, intermedio ? intermedio + i : nullptr, dst + i, dataSize - i, bits);
+}
+
+OBJETIVO_CPU("sse2")
+static void rotarXor_SSE2(const unsigned char* a, const unsigned char* b, unsigned char* dst, size_t dataSize, int bits) {
+    const RotacionSSE2 r = prepararRotacionSSE2(bits);
+    size_t i = 0;
+    for (; i + 16 <= dataSize; i += 16) {
+        __m128i x = rotarSSE2(_mm_loadu_si128((const __m128i*)(a + i)), r);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(x, _mm_loadu_si128((const __m128i*)(b + i))));
+    }
+    rotarXor_Escalar(a + i, b + i, dst + i, dataSize - i, bits);
+}
+
+struct RotacionAVX2 {
+    __m128i cuentaIzq, cuentaDer;
+    __m256i mascaraIzq, mascaraDer;
+};
+
+OBJETIVO_CPU("avx2")
+static inline RotacionAVX2 prepararRotacionAVX2(int bits) {
+    RotacionAVX2 r;
+    r.cuentaIzq = _mm_cvtsi32_si128(bits);
+    r.cuentaDer = _mm_cvtsi32_si128(8 - bits);
+    r.mascaraIzq = _mm256_set1_epi8((char)(0xFF << bits));
+    r.mascaraDer = _mm256_set1_epi8((char)(0xFF >> (8 - bits)));
+    return r;
+}
+
+OBJETIVO_CPU("avx2")
+static inline __m256i rotarAVX2(__m256i x, const RotacionAVX2& r) {
+    return _mm256_or_si256(_mm256_and_si256(_mm256_sll_epi16(x, r.cuentaIzq), r.mascaraIzq),
+                           _mm256_and_si256(_mm256_srl_epi16(x, r.cuentaDer), r.mascaraDer));
+}
+
+OBJETIVO_CPU("avx2")
+static void rotarIzquierda_AVX2(const unsigned char* src, unsigned char* dst, size_t dataSize, int bits) {
+    const RotacionAVX2 r = prepararRotacionAVX2(bits);
+    size_t i = 0;
+    for (; i + 64 <= dataSize; i += 64) {
+        __m256i x0 = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i x1 = _mm256_loadu_si256((const __m256i*)(src + i + 32));
+        _mm256_storeu_si256((__m256i*)(dst + i), rotarAVX2(x0, r));
+        _mm256_storeu_si256((__m256i*)(dst + i + 32), rotarAVX2(x1, r));
+    }
+    for (; i + 32 <= dataSize; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), rotarAVX2(x, r));
+    }
+    _mm256_zeroupper();
+    rotarIzquierda_Escalar(src + i, dst + i, dataSize - i, bits);
+}
+
+OBJETIVO_CPU("avx2")
+static void xorRotar_AVX2(const unsigned char* a, const unsigned char* b, unsigned char* intermedio,
+                          unsigned char* dst, size_t dataSize, int bits) {
+    const RotacionAVX2 r = prepararRotacionAVX2(bits);
+    size_t i = 0;
+    for (; i + 32 <= dataSize; i += 32) {
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i)),
+                                     _mm256_loadu_si256((const __m256i*)(b + i)));
+        if (intermedio != nullptr) _mm256_storeu_si256((__m256i*)(intermedio + i), x);
+        _mm256_storeu_si256((__m256i*)(dst + i), rotarAVX2(x, r));
+    }
+    _mm256_zeroupper();
+    xorRotar_Escalar(a + i, b + i, intermedio ? intermedio + i : nullptr, dst + i, dataSize - i, bits);
+}
+
+OBJETIVO_CPU("avx2")
+static void rotarXor_AVX2(const unsigned char* a, const unsigned char* b, unsigned char* dst, size_t dataSize, int bits) {
+    const RotacionAVX2 r = prepararRotacionAVX2(bits);
+    size_t i = 0;
+    for (; i + 32 <= dataSize; i += 32) {
+        __m256i x = rotarAVX2(_mm256_loadu_si256((const __m256i*)(a + i)), r);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(x, _mm256_loadu_si256((const __m256i*)(b + i))));
+    }
+    _mm256_zeroupper();
+    rotarXor_Escalar(a + i, b + i, dst + i, dataSize - i, bits);
+}
+
+// Matriz 8x8 sobre GF(2) para GF2P8AFFINEQB: el bit i del resultado toma el bit (i - bits) mod 8
+// de la entrada. La fila del bit i de salida está en el byte 7 - i de la constante de 64 bits.
+static long long matrizRotacionIzquierda(int bits) {
+    unsigned long long matriz = 0;
+    for (int i = 0; i < 8; ++i) {
+        matriz |= (unsigned long long)(1u << ((i - bits) & 7)) << (8 * (7 - i));
+    }
+    return (long long)matriz;
+}
+
+// Con GFNI la rotación completa es una sola instrucción por registro
+OBJETIVO_CPU("gfni,avx2")
+static void rotarIzquierda_GFNI(const unsigned char* src, unsigned char* dst, size_t dataSize, int bits) {
+    const __m256i matriz = _mm256_set1_epi64x(matrizRotacionIzquierda(bits));
+    size_t i = 0;
+    for (; i + 64 <= dataSize; i += 64) {
+        __m256i x0 = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i x1 = _mm256_loadu_si256((const __m256i*)(src + i + 32));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_gf2p8affine_epi64_epi8(x0, matriz, 0));
+        _mm256_storeu_si256((__m256i*)(dst + i + 32), _mm256_gf2p8affine_epi64_epi8(x1, matriz, 0));
+    }
+    for (; i + 32 <= dataSize; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_gf2p8affine_epi64_epi8(x, matriz, 0));
+    }
+    _mm256_zeroupper();
+    rotarIzquierda_Escalar(src + i, dst + i, dataSize - i, bits);
+}
+
+OBJETIVO_CPU("gfni,avx2")
+static void xorRotar_GFNI(const unsigned char* a, const unsigned char* b, unsigned char* intermedio,
+                          unsigned char* dst, size_t dataSize, int bits) {
+    const __m256i matriz = _mm256_set1_epi64x(matrizRotacionIzquierda(bits));
+    size_t i = 0;
+    for (; i + 32 <= dataSize; i += 32) {
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i)),
+                                     _mm256_loadu_si256((const __m256i*)(b + i)));
+        if (intermedio != nullptr) _mm256_storeu_si256((__m256i*)(intermedio + i), x);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_gf2p8affine_epi64_epi8(x, matriz, 0));
+    }
+    _mm256_zeroupper();
+    xorRotar_Escalar(a + i, b + i, intermedio ? intermedio + i : nullptr, dst + i, dataSize - i, bits);
+}
+
+OBJETIVO_CPU("gfni,avx2")
+static void rotarXor_GFNI(const unsigned char* a, const unsigned char* b, unsigned char* dst, size_t dataSize, int bits) {
+    const __m256i matriz = _mm256_set1_epi64x(matrizRotacionIzquierda(bits));
+    size_t i = 0;
+    for (; i + 32 <= dataSize; i += 32) {
+        __m256i x = _mm256_gf2p8affine_epi64_epi8(_mm256_loadu_si256((const __m256i*)(a + i)), matriz, 0);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(x, _mm256_loadu_si256((const __m256i*)(b + i))));
+    }
+    _mm256_zeroupper();
+    rotarXor_Escalar(a + i, b + i, dst + i, dataSize - i, bits);
+}
+#endif
+
+// Juego de kernels de rotación elegido al arrancar; las tres variantes usan siempre el mismo ISA
+struct KernelsRotacion {
+    KernelRotacion rotar;
+    KernelXORRotacion xorRotar;
+    KernelRotacionXOR rotarXor;
+};
+
+static KernelsRotacion seleccionarKernelsRotacion() {
+#ifdef DESAFIO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("gfni") && __builtin_cpu_supports("avx2"))
+        return { rotarIzquierda_GFNI, xorRotar_GFNI, rotarXor_GFNI };
+    if (__builtin_cpu_supports("avx2"))
+        return { rotarIzquierda_AVX2, xorRotar_AVX2, rotarXor_AVX2 };
+    if (__builtin_cpu_supports("sse2"))
+        return { rotarIzquierda_SSE2, xorRotar_SSE2, rotarXor_SSE2 };
+#endif
+    return { rotarIzquierda_Escalar, xorRotar_Escalar, rotarXor_Escalar };
+}
+
+static const KernelsRotacion kernelsRotacion = seleccionarKernelsRotacion();
+
+// Reparto de los kernels de rotación entre los hilos del pool. Cada parte recibe un rango que es
+// múltiplo de la línea de caché, así que en buffers alineados dos hilos no escriben en la misma línea.
+struct ContextoRotacion {
+    const unsigned char* a;
+    const unsigned char* b;
+    unsigned char* intermedio;
+    unsigned char* dst;
+    int bits;
+};
+
+static void tareaRotar(void* contexto, size_t desde, size_t hasta) {
+    const ContextoRotacion* c = (const ContextoRotacion*)contexto;
+    kernelsRotacion.rotar(c->a + desde, c->dst + desde, hasta - desde, c->bits);
+}
+
+static void tareaXORRotar(void* contexto, size_t desde, size_t hasta) {
+    const ContextoRotacion* c = (const ContextoRotacion*)contexto;
+    kernelsRotacion.xorRotar(c->a + desde, c->b + desde, c->intermedio != nullptr ? c->intermedio + desde : nullptr,
+                             c->dst + desde, hasta - desde, c->bits);
+}
+
+static void tareaRotarXOR(void* contexto, size_t desde, size_t hasta) {
+    const ContextoRotacion* c = (const ContextoRotacion*)contexto;
+    kernelsRotacion.rotarXor(c->a + desde, c->b + desde, c->dst + desde, hasta - desde, c->bits);
+}
+
+// dst = rotl(src, bitsIzquierda), repartido entre los hilos del pool; dst puede ser src
+static void rotarEnParalelo(const unsigned char* src, unsigned char* dst, size_t dataSize, int bitsIzquierda) {
+    SpanTraza traza("rotar", dataSize);
+    bitsIzquierda &= 7;
+    if (bitsIzquierda == 0) {
+        if (src != dst) memcpy(dst, src, dataSize);
+        return;
+    }
+    ContextoRotacion contexto = {src, nullptr, nullptr, dst, bitsIzquierda};
+    ejecutarEnParalelo(tareaRotar, &contexto, dataSize);
+}
+
+// Para la rotacion de bits a la derecha
+void rotateBitsRight(unsigned char* data, size_t dataSize, int bits) {
+    bits &= 7;
+    if (bits == 0) return;
+    rotarEnParalelo(data, data, dataSize, 8 - bits);
+}
+// Para la rotacion de bits a la izquierda
+void rotateBitsLeft(unsigned char* data, size_t dataSize, int bits) {
+    bits &= 7;
+    if (bits == 0) return;
+    rotarEnParalelo(data, data, dataSize, bits);
+}
+
+// XOR seguido de rotación a la derecha en una sola pasada: result = ror(img1 ^ img2, bits).
+// Si resultadoXOR no es nulo, también deja ahí el XOR sin rotar (útil para exportar P1 sin una
+// segunda lectura de las imágenes).
+void applyXORRotateRight(const unsigned char* img1, const unsigned char* img2, unsigned char* resultadoXOR,
+                         unsigned char* result, size_t dataSize, int bits) {
+    SpanTraza traza("applyXORRotateRight", dataSize);
+    bits &= 7;
+    ContextoRotacion contexto = {img1, img2, resultadoXOR, result, (8 - bits) & 7};
+    ejecutarEnParalelo(tareaXORRotar, &contexto, dataSize);
+}
+
+// Rotación a la izquierda seguida de XOR en una sola pasada: result = rol(img1, bits) ^ img2.
+// Es la inversa exacta de applyXORRotateRight con los mismos img2 y bits.
+void applyRotateLeftXOR(const unsigned char* img1, const unsigned char* img2, unsigned char* result, size_t dataSize, int bits) {
+    SpanTraza traza("applyRotateLeftXOR", dataSize);
+    ContextoRotacion contexto = {img1, img2, nullptr, result, bits & 7};
+    ejecutarEnParalelo(tareaRotarXOR, &contexto, dataSize);
+}
+
+// ---------------------------------------------------------------------------------------------
+// Cadenas de transformaciones
+//
+// Todas las operaciones soportadas (rotaciones, desplazamientos y XOR) son lineales sobre GF(2)
+// salvo por una constante: f(x ^ y) = f(x) ^ f(y) ^ f(0). Por eso cualquier cadena se reduce a
+//     f(x) = L(x) ^ c ^ M[i]
+// donde L es una función lineal de 8 bits, c una constante y M el XOR de las imágenes de la
+// cadena, cada una pasada por las operaciones que la siguen (rot(x ^ m) = rot(x) ^ rot(m)).
+// Al ser lineal, L(x) = L(x & 0x0F) ^ L(x & 0xF0), así que la tabla de 256 entradas se guarda como
+// dos tablas de 16 que caben en un registro y se consultan con pshufb.
+// ---------------------------------------------------------------------------------------------
+
+void iniciarCadena(CadenaTransformaciones &cadena) {
+    cadena.n_ops = 0;
+    cadena.esIdentidad = true;
+    cadena.hayImagenes = false;
+    cadena.mascara = nullptr;
+    cadena.tamanoMascara = 0;
+    for (int i = 0; i < 16; ++i) {
+        cadena.tablaBaja[i] = (unsigned char)i;
+        cadena.tablaAlta[i] = (unsigned char)(i << 4);
+    }
+}
+
+bool agregarOperacion(CadenaTransformaciones &cadena, TipoOperacion tipo, int parametro, const unsigned char* imagen) {
+    if (cadena.n_ops >= MAX_OPERACIONES_CADENA) {
+        cout << "Error: la cadena de transformaciones está llena." << endl;
+        return false;
+    }
+    cadena.ops[cadena.n_ops].tipo = tipo;
+    cadena.ops[cadena.n_ops].parametro = parametro;
+    cadena.ops[cadena.n_ops].imagen = imagen;
+    cadena.n_ops++;
+    return true;
+}
+
+// Evalúa las operaciones [desde, n_ops) sobre un byte, tomando las imágenes como cero
+static unsigned char evaluarOperaciones(const CadenaTransformaciones &cadena, int desde, unsigned char x) {
+    for (int k = desde; k < cadena.n_ops; ++k) {
+        const OperacionByte &op = cadena.ops[k];
+        int bits = op.parametro & 7;
+        switch (op.tipo) {
+        case OP_XOR_IMAGEN:    break;
+        case OP_XOR_CONSTANTE: x ^= (unsigned char)op.parametro; break;
+        case OP_ROTAR_IZQ:     x = rotarByteIzquierda(x, bits); break;
+        case OP_ROTAR_DER:     x = rotarByteIzquierda(x, (8 - bits) & 7); break;
+        case OP_DESPLAZAR_IZQ: x = (op.parametro >= 8) ? 0 : (unsigned char)(x << op.parametro); break;
+        case OP_DESPLAZAR_DER: x = (op.parametro >= 8) ? 0 : (unsigned char)(x >> op.parametro); break;
+        }
+    }
+    return x;
+}
+
+// Parte lineal de las operaciones [desde, n_ops), como tabla de 256 entradas
+static void tablaLinealSufijo(const CadenaTransformaciones &cadena, int desde, unsigned char lineal[256]) {
+    unsigned char cero = evaluarOperaciones(cadena, desde, 0);
+    for (int v = 0; v < 256; ++v) {
+        lineal[v] = evaluarOperaciones(cadena, desde, (unsigned char)v) ^ cero;
+    }
+}
+
+// Calcula solo las tablas de nibbles, sin recorrer ninguna imagen
+void compilarTablasCadena(CadenaTransformaciones &cadena) {
+    // Tablas de nibbles de la parte sin imágenes
+    unsigned char cero = evaluarOperaciones(cadena, 0, 0);
+    cadena.esIdentidad = true;
+    for (int i = 0; i < 16; ++i) {
+        cadena.tablaBaja[i] = evaluarOperaciones(cadena, 0, (unsigned char)i);
+        cadena.tablaAlta[i] = evaluarOperaciones(cadena, 0, (unsigned char)(i << 4)) ^ cero;
+        if (cadena.tablaBaja[i] != i || cadena.tablaAlta[i] != (i << 4)) cadena.esIdentidad = false;
+    }
+
+    // Si todas las imágenes son la misma, su aporte es la suma (XOR) de las partes lineales
+    cadena.hayImagenes = false;
+    memset(cadena.tablaImagenBaja, 0, sizeof(cadena.tablaImagenBaja));
+    memset(cadena.tablaImagenAlta, 0, sizeof(cadena.tablaImagenAlta));
+    for (int k = 0; k < cadena.n_ops; ++k) {
+        if (cadena.ops[k].tipo != OP_XOR_IMAGEN) continue;
+        cadena.hayImagenes = true;
+        unsigned char lineal[256];
+        tablaLinealSufijo(cadena, k + 1, lineal);
+        for (int i = 0; i < 16; ++i) {
+            cadena.tablaImagenBaja[i] ^= lineal[i];
+            cadena.tablaImagenAlta[i] ^= lineal[i << 4];
+        }
+    }
+}
+
+void liberarCadena(CadenaTransformaciones &cadena) {
+    liberarBufferPixeles(cadena.mascara);
+    cadena.mascara = nullptr;
+    cadena.tamanoMascara = 0;
+    cadena.n_ops = 0;
+}
+
+// Variantes de la aplicación de la tabla. mascara puede ser nullptr.
+typedef void (*KernelTabla)(const unsigned char*, const unsigned char*, const unsigned char*,
+                            const unsigned char*, unsigned char*, size_t);
+
+static void aplicarTabla_Escalar(const unsigned char* tablaBaja, const unsigned char* tablaAlta,
+                                 const unsigned char* mascara, const unsigned char* src, unsigned char* dst, size_t dataSize) {
+    unsigned char tabla[256];
+    for (int v = 0; v < 256; ++v) tabla[v] = tablaBaja[v & 0x0F] ^ tablaAlta[v >> 4];
+    if (mascara != nullptr) {
+        for (size_t i = 0; i < dataSize; ++i) dst[i] = tabla[src[i]] ^ mascara[i];
+    } else {
+        for (size_t i = 0; i < dataSize; ++i) dst[i] = tabla[src[i]];
+    }
+}
+
+#ifdef DESAFIO_X86
+OBJETIVO_CPU("ssse3")
+static void aplicarTabla_SSSE3(const unsigned char* tablaBaja, const unsigned char* tablaAlta,
+                               const unsigned char* mascara, const unsigned char* src, unsigned char* dst, size_t dataSize) {
+    const __m128i baja = _mm_loadu_si128((const __m128i*)tablaBaja);
+    const __m128i alta = _mm_loadu_si128((const __m128i*)tablaAlta);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; i + 16 <= dataSize; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = _mm_and_si128(x, nibble);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), nibble);
+        __m128i r = _mm_xor_si128(_mm_shuffle_epi8(baja, lo), _mm_shuffle_epi8(alta, hi));
+        if (mascara != nullptr) r = _mm_xor_si128(r, _mm_loadu_si128((const __m128i*)(mascara + i)));
+        _mm_storeu_si128((__m128i*)(dst + i), r);
+    }
+    aplicarTabla_Escalar(tablaBaja, tablaAlta, mascara ? mascara + i : nullptr, src + i, dst + i, dataSize - i);
+}
+
+OBJETIVO_CPU("avx2")
+static void aplicarTabla_AVX2(const unsigned char* tablaBaja, const unsigned char* tablaAlta,
+                              const unsigned char* mascara, const unsigned char* src, unsigned char* dst, size_t dataSize) {
+    // vpshufb consulta cada mitad de 128 bits por separado: la tabla se replica en ambas
+    const __m256i baja = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)tablaBaja));
+    const __m256i alta = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)tablaAlta));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; i + 32 <= dataSize; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i lo = _mm256_and_si256(x, nibble);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+        __m256i r = _mm256_xor_si256(_mm256_shuffle_epi8(baja, lo), _mm256_shuffle_epi8(alta, hi));
+        if (mascara != nullptr) r = _mm256_xor_si256(r, _mm256_loadu_si256((const __m256i*)(mascara + i)));
+        _mm256_storeu_si256((__m256i*)(dst + i), r);
+    }
+    _mm256_zeroupper();
+    aplicarTabla_Escalar(tablaBaja, tablaAlta, mascara ? mascara + i : nullptr, src + i, dst + i, dataSize - i);
+}
+#endif
+
+static KernelTabla seleccionarKernelTabla() {
+#ifdef DESAFIO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return aplicarTabla_AVX2;
+    if (__builtin_cpu_supports("ssse3")) return aplicarTabla_SSSE3;
+#endif
+    return aplicarTabla_Escalar;
+}
+
+static const KernelTabla kernelTabla = seleccionarKernelTabla();
+
+// Aplica unas tablas de nibbles en paralelo: dst[i] = T(src[i]) ^ mascara[i]. mascara puede ser
+// nullptr o coincidir con dst.
+struct ContextoTabla {
+    const unsigned char* tablaBaja;
+    const unsigned char* tablaAlta;
+    const unsigned char* mascara;
+    const unsigned char* src;
+    unsigned char* dst;
+};
+
+static void tareaTabla(void* contexto, size_t desde, size_t hasta) {
+    const ContextoTabla* c = (const ContextoTabla*)contexto;
+    const unsigned char* mascara = c->mascara != nullptr ? c->mascara + desde : nullptr;
+    kernelTabla(c->tablaBaja, c->tablaAlta, mascara, c->src + desde, c->dst + desde, hasta - desde);
+}
+
+bool compilarCadena(CadenaTransformaciones &cadena, size_t dataSize) {
+    compilarTablasCadena(cadena);
+
+    liberarBufferPixeles(cadena.mascara);
+    cadena.mascara = nullptr;
+    cadena.tamanoMascara = 0;
+    const unsigned char* unica = nullptr;
+    bool todasIguales = true;
+    for (int k = 0; k < cadena.n_ops; ++k) {
+        if (cadena.ops[k].tipo != OP_XOR_IMAGEN) continue;
+        if (cadena.ops[k].imagen == nullptr) {
+            cout << "Error: OP_XOR_IMAGEN necesita una imagen para compilar la máscara completa." << endl;
+            return false;
+        }
+        if (unica == nullptr) unica = cadena.ops[k].imagen;
+        else if (cadena.ops[k].imagen != unica) todasIguales = false;
+    }
+    if (unica == nullptr) return true;
+
+    SpanTraza traza("compilarCadena", dataSize);
+    cadena.mascara = reservarBufferPixeles(dataSize);
+    cadena.tamanoMascara = dataSize;
+
+    // Máscara: cada imagen pasada por la parte lineal de las operaciones que la siguen, con el mismo
+    // kernel de tablas que aplicarCadena. Si todas las imágenes son la misma basta una pasada con la
+    // suma de esas partes lineales (tablaImagen), que es lo habitual (I_M en cada XOR).
+    if (todasIguales) {
+        ContextoTabla contexto = {cadena.tablaImagenBaja, cadena.tablaImagenAlta, nullptr, unica, cadena.mascara};
+        ejecutarEnParalelo(tareaTabla, &contexto, dataSize);
+        return true;
+    }
+    bool primera = true;
+    for (int k = 0; k < cadena.n_ops; ++k) {
+        if (cadena.ops[k].tipo != OP_XOR_IMAGEN) continue;
+        unsigned char lineal[256];
+        tablaLinealSufijo(cadena, k + 1, lineal);
+        unsigned char baja[16], alta[16];
+        for (int i = 0; i < 16; ++i) {
+            baja[i] = lineal[i];
+            alta[i] = lineal[i << 4];
+        }
+        ContextoTabla contexto = {baja, alta, primera ? nullptr : cadena.mascara, cadena.ops[k].imagen,
+                                  cadena.mascara};
+        ejecutarEnParalelo(tareaTabla, &contexto, dataSize);
+        primera = false;
+    }
+    return true;
+}
+
+// Aplica una cadena ya compilada: dst[i] = f(src[i]) ^ mascara[i]. src y dst pueden coincidir.
+struct ContextoCadena {
+    const CadenaTransformaciones* cadena;
+    const unsigned char* src;
+    unsigned char* dst;
+};
+
+static void tareaCadena(void* contexto, size_t desde, size_t hasta) {
+    const ContextoCadena* c = (const ContextoCadena*)contexto;
+    const unsigned char* mascara = c->cadena->mascara != nullptr ? c->cadena->mascara + desde : nullptr;
+    kernelTabla(c->cadena->tablaBaja, c->cadena->tablaAlta, mascara, c->src + desde, c->dst + desde, hasta - desde);
+}
+
+void aplicarCadena(const CadenaTransformaciones &cadena, const unsigned char* src, unsigned char* dst, size_t dataSize) {
+    SpanTraza traza("aplicarCadena", dataSize);
+    const unsigned char* mascara = cadena.mascara;
+    if (mascara != nullptr && cadena.tamanoMascara < dataSize) {
+        cout << "Error: la cadena se compiló para un tamaño menor (" << cadena.tamanoMascara << " bytes)." << endl;
+        return;
+    }
+
+    if (cadena.esIdentidad) {
+        // Sin tabla que aplicar: a lo sumo un XOR con la máscara
+        if (mascara != nullptr) {
+            applyXOR(src, mascara, dst, dataSize);
+        } else if (src != dst) {
+            memcpy(dst, src, dataSize);
+        }
+        return;
+    }
+    ContextoCadena contexto = {&cadena, src, dst};
+    ejecutarEnParalelo(tareaCadena, &contexto, dataSize);
+}
+
+// Aplica una cadena a un BMP completo sin cargarlo en memoria: la entrada (y la imagen de los
+// OP_XOR_IMAGEN, normalmente I_M) se leen por franjas de alturaFranja filas, cada franja se
+// transforma y se escribe en el BMP de salida antes de leer la siguiente. La memoria usada es
+// O(ancho * alturaFranja). Todas las operaciones OP_XOR_IMAGEN de la cadena se refieren a la
+// imagen imagenXOR, que puede ser nullptr si la cadena no tiene ninguna.
+bool procesarBMPPorFranjas(const char* entrada, const char* imagenXOR, const char* salida,
+                           CadenaTransformaciones &cadena, int alturaFranja) {
+    SpanTraza traza("procesarBMPPorFranjas");
+    compilarTablasCadena(cadena);
+    if (cadena.hayImagenes && imagenXOR == nullptr) {
+        cout << "Error: la cadena tiene XOR con imagen pero no se indicó la imagen." << endl;
+        return false;
+    }
+    if (alturaFranja <= 0) alturaFranja = 1;
+
+    LectorBMP lectorEntrada;
+    if (!abrirLectorBMP(entrada, lectorEntrada)) {
+        cout << "Error: No se pudo abrir " << entrada << " para procesarlo por franjas." << endl;
+        return false;
+    }
+    int width = lectorEntrada.width;
+    int height = lectorEntrada.height;
+    traza.bytes = (size_t)width * height * 3;
+
+    LectorBMP lectorXOR;
+    lectorXOR.archivo = nullptr;
+    lectorXOR.buffer = nullptr;
+    if (cadena.hayImagenes) {
+        if (!abrirLectorBMP(imagenXOR, lectorXOR) || lectorXOR.width != width || lectorXOR.height != height) {
+            cout << "Error: " << imagenXOR << " no se pudo abrir o no tiene el tamaño de la entrada." << endl;
+            cerrarLectorBMP(lectorXOR);
+            cerrarLectorBMP(lectorEntrada);
+            return false;
+        }
+    }
+
+    EscritorBMP escritor;
+    if (!abrirEscritorBMP(salida, width, height, escritor)) {
+        cout << "Error: No se pudo crear " << salida << endl;
+        cerrarLectorBMP(lectorXOR);
+        cerrarLectorBMP(lectorEntrada);
+        return false;
+    }
+
+    if (alturaFranja > height) alturaFranja = height;
+    size_t bytesFranja = (size_t)width * 3 * (size_t)alturaFranja;
+    unsigned char* franja = reservarBufferPixeles(bytesFranja);
+    unsigned char* franjaXOR = cadena.hayImagenes ? reservarBufferPixeles(bytesFranja) : nullptr;
+
+    // Se avanza de abajo hacia arriba para que las lecturas y escrituras sean secuenciales en
+    // archivos BMP guardados de abajo hacia arriba
+    bool ok = true;
+    for (int fin = height; fin > 0 && ok; fin -= alturaFranja) {
+        int inicio = fin - alturaFranja;
+        if (inicio < 0) inicio = 0;
+        int nFilas = fin - inicio;
+        size_t bytes = (size_t)width * 3 * (size_t)nFilas;
+
+        ok = leerFilasBMP(lectorEntrada, inicio, nFilas, franja);
+        if (ok && franjaXOR != nullptr) {
+            ok = leerFilasBMP(lectorXOR, inicio, nFilas, franjaXOR);
+            // Máscara de la franja: la imagen pasada por la parte lineal de las operaciones posteriores
+            if (ok) kernelTabla(cadena.tablaImagenBaja, cadena.tablaImagenAlta, nullptr, franjaXOR, franjaXOR, bytes);
+        }
+        if (ok) {
+            kernelTabla(cadena.tablaBaja, cadena.tablaAlta, franjaXOR, franja, franja, bytes);
+            ok = escribirFilasBMP(escritor, franja, inicio, nFilas);
+        }
+    }
+
+    liberarBufferPixeles(franja);
+    liberarBufferPixeles(franjaXOR);
+    cerrarLectorBMP(lectorXOR);
+    cerrarLectorBMP(lectorEntrada);
+    ok = cerrarEscritorBMP(escritor) && ok;
+
+    if (ok) {
+        cout << "Imagen BMP procesada por franjas de " << alturaFranja << " filas guardada como " << salida << endl;
+    } else {
+        cout << "Error: No se pudo procesar " << entrada << " por franjas." << endl;
+    }
+    return ok;
+}
+
+// Avanza sobre espacios, tabulaciones y saltos de línea (incluido el \r de los archivos de Windows)
+static const char* saltarEspacios(const char* p, const char* fin) {
+    while (p < fin && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) ++p;
+    return p;
+}
+
+// Definida con el resto del formato binario, más abajo
+static unsigned short* cargarEnmascaramientoBinario(const ArchivoMapeado &archivo, const char* nombreArchivo,
+                                                    int &seed, int &n_pixels);
+
+unsigned short* loadSeedMasking(const char* nombreArchivo, int &seed, int &n_pixels){
+    /*
+ * @brief Carga la semilla y los resultados del enmascaramiento desde un archivo de texto.
+ *
+ * Esta función proyecta en memoria un archivo de texto que contiene una semilla en la primera línea
+ * y, a continuación, una lista de valores RGB resultantes del proceso de enmascaramiento. El archivo
+ * se recorre una sola vez: cada número se convierte con std::from_chars y se valida al leerlo, y el
+ * arreglo de salida crece de forma geométrica a medida que aparecen tripletas.
+ *
+ * @param nombreArchivo Ruta del archivo de texto que contiene la semilla y los valores RGB.
+ * @param seed Variable de referencia donde se almacenará el valor entero de la semilla.
+ * @param n_pixels Variable de referencia donde se almacenará la cantidad de píxeles leídos
+ *                 (equivalente al número de líneas después de la semilla).
+ *
+ * @return Puntero a un arreglo dinámico de enteros de 16 bits que contiene los valores RGB
+ *         en orden secuencial (R, G, B, R, G, B, ...). Devuelve nullptr si ocurre un error al abrir
+ *         el archivo o si su contenido no es válido (números mal formados, valores fuera de 0..510
+ *         o una tripleta incompleta).
+ *
+ * @note Es responsabilidad del usuario liberar la memoria reservada con delete[].
+ */
+    SpanTraza traza("loadSeedMasking");
+
+    n_pixels = 0;
+
+    // Proyectar el archivo que contiene la semilla y los valores RGB
+    ArchivoMapeado archivo;
+    if (!mapearArchivo(nombreArchivo, archivo)) {
+        // Verificar si el archivo pudo abrirse correctamente
+        cout << "No se pudo abrir el archivo." << endl;
+        return nullptr;
+    }
+    traza.bytes = archivo.tamano;
+
+    // Los archivos binarios ("DMSK") no se interpretan: se validan y se copian tal cual (para usarlos
+    // sin copiarlos está abrirVistaEnmascaramiento)
+    if (archivo.tamano >= 4 && memcmp(archivo.datos, "DMSK", 4) == 0) {
+        unsigned short* binario = cargarEnmascaramientoBinario(archivo, nombreArchivo, seed, n_pixels);
+        liberarMapeo(archivo);
+        if (binario != nullptr) {
+            cout << "Semilla: " << seed << endl;
+            cout << "Cantidad de píxeles leídos: " << n_pixels << endl;
+        }
+        return binario;
+    }
+
+    const char* p = (const char*)archivo.datos;
+    const char* fin = p + archivo.tamano;
+
+    // Leer la semilla desde la primera línea del archivo
+    p = saltarEspacios(p, fin);
+    from_chars_result leido = from_chars(p, fin, seed);
+    if (leido.ec != errc()) {
+        cout << "Error: el archivo " << nombreArchivo << " no empieza con una semilla válida." << endl;
+        liberarMapeo(archivo);
+        return nullptr;
+    }
+    p = leido.ptr;
+
+    // Capacidad inicial estimada a partir del tamaño (una línea típica ocupa unos 12 bytes); si
+    // se queda corta se duplica
+    size_t capacidad = archivo.tamano / 12 * 3 + 3;
+    size_t n_valores = 0;
+    unsigned short* RGB = new unsigned short[capacidad];
+
+    bool valido = true;
+    while (true) {
+        p = saltarEspacios(p, fin);
+        if (p == fin) break;
+
+        unsigned int valor = 0;
+        leido = from_chars(p, fin, valor);
+        if (leido.ec != errc() || valor > 510) {
+            cout << "Error: valor inválido en la tripleta " << n_valores / 3 << " de " << nombreArchivo << endl;
+            valido = false;
+            break;
+        }
+        p = leido.ptr;
+
+        if (n_valores == capacidad) {
+            size_t nuevaCapacidad = capacidad * 2;
+            unsigned short* nuevo = new unsigned short[nuevaCapacidad];
+            memcpy(nuevo, RGB, n_valores * sizeof(unsigned short));
+            delete[] RGB;
+            RGB = nuevo;
+            capacidad = nuevaCapacidad;
+        }
+        RGB[n_valores++] = (unsigned short)valor;
+    }
+
+    if (valido && n_valores % 3 != 0) {
+        cout << "Error: el archivo " << nombreArchivo << " termina con una tripleta incompleta." << endl;
+        valido = false;
+    }
+
+    // Liberar la proyección después de terminar la lectura
+    liberarMapeo(archivo);
+
+    if (valido && n_valores / 3 > (size_t)MAX_PIXELES_ENMASCARAMIENTO) {
+        cout << "Error: el archivo " << nombreArchivo << " tiene demasiados píxeles." << endl;
+        valido = false;
+    }
+    if (!valido) {
+        delete[] RGB;
+        return nullptr;
+    }
+    n_pixels = (int)(n_valores / 3);
+
+    // Mostrar información de control en consola
+    cout << "Semilla: " << seed << endl;
+    cout << "Cantidad de píxeles leídos: " << n_pixels << endl;
+
+    // Retornar el puntero al arreglo con los datos RGB
+    return RGB;
+}
+
+
+
+// Fin de línea de los archivos de enmascaramiento. Se escribe en modo binario, así que se reproduce a
+// mano lo que hacía ofstream en modo texto en cada sistema.
+#ifdef _WIN32
+static const char SALTO_LINEA[] = "\r\n";
+#else
+static const char SALTO_LINEA[] = "\n";
+#endif
+static const int LONGITUD_SALTO_LINEA = (int)sizeof(SALTO_LINEA) - 1;
+
+// Bytes máximos de una línea "rrr ggg bbb" más el salto de línea
+static const int MAX_BYTES_LINEA_ENMASCARAMIENTO = 3 * 3 + 2 + 2;
+
+// Texto de cada suma posible (0..510), para formatear sin divisiones. Cada entrada ocupa 4 bytes
+// para poder copiarla entera de una vez y avanzar solo su longitud real.
+struct TablaDigitos {
+    char texto[511][4];
+    unsigned char longitud[511];
+};
+
+static TablaDigitos construirTablaDigitos() {
+    TablaDigitos tabla;
+    for (int v = 0; v <= 510; ++v) {
+        char* t = tabla.texto[v];
+        memset(t, ' ', 4);
+        if (v >= 100) {
+            t[0] = (char)('0' + v / 100);
+            t[1] = (char)('0' + v / 10 % 10);
+            t[2] = (char)('0' + v % 10);
+            tabla.longitud[v] = 3;
+        } else if (v >= 10) {
+            t[0] = (char)('0' + v / 10);
+            t[1] = (char)('0' + v % 10);
+            tabla.longitud[v] = 2;
+        } else {
+            t[0] = (char)('0' + v);
+            tabla.longitud[v] = 1;
+        }
+    }
+    return tabla;
+}
+
+static const TablaDigitos tablaDigitos = construirTablaDigitos();
+
+// Formatea las líneas de los píxeles [desde, hasta) de la máscara en destino, que debe tener espacio
+// para (hasta - desde) * MAX_BYTES_LINEA_ENMASCARAMIENTO + 4 bytes. Devuelve los bytes escritos.
+static size_t formatearLineasEnmascaramiento(char* destino, const unsigned char* datos, const unsigned char* mascara,
+                                             int offset, int desde, int hasta) {
+    char* p = destino;
+    const unsigned char* d = datos + ((size_t)offset + desde) * 3;
+    const unsigned char* m = mascara + (size_t)desde * 3;
+    for (int k = desde; k < hasta; ++k, d += 3, m += 3) {
+        for (int c = 0; c < 3; ++c) {
+            int suma = d[c] + m[c];
+            memcpy(p, tablaDigitos.texto[suma], 4);
+            p += tablaDigitos.longitud[suma];
+            *p++ = ' ';
+        }
+        // El último espacio se reemplaza por el salto de línea
+        memcpy(p - 1, SALTO_LINEA, LONGITUD_SALTO_LINEA);
+        p += LONGITUD_SALTO_LINEA - 1;
+    }
+    return (size_t)(p - destino);
+}
+
+// Por debajo de esta cantidad de píxeles el formateo se hace en un solo hilo
+static const int MIN_PIXELES_ENMASCARAMIENTO_PARALELO = 1 << 16;
+
+struct ContextoFormateo {
+    const unsigned char* datos;
+    const unsigned char* mascara;
+    int offset;
+    int n_pixels;
+    int pixelesPorBloque;
+    int ronda;
+    char** buffers;
+    size_t* usados;
+};
+
+// Formatea los bloques [desde, hasta) de la ronda actual, cada uno en su buffer
+static void tareaFormateo(void* contexto, size_t desde, size_t hasta) {
+    ContextoFormateo* c = (ContextoFormateo*)contexto;
+    for (size_t h = desde; h < hasta; ++h) {
+        int inicio = c->ronda + (int)h * c->pixelesPorBloque;
+        int fin = inicio + c->pixelesPorBloque < c->n_pixels ? inicio + c->pixelesPorBloque : c->n_pixels;
+        c->usados[h] = formatearLineasEnmascaramiento(c->buffers[h], c->datos, c->mascara, c->offset, inicio, fin);
+    }
+}
+
+// Escribe un archivo de enmascaramiento: la semilla (offset) y, por cada píxel de la máscara, la
+// suma datos[offset + k] + mascara[k] de cada canal. datos debe tener al menos (offset + n_pixels) * 3
+// bytes y mascara n_pixels * 3. Las líneas se formatean con tablaDigitos en buffers grandes que se
+// escriben con pocas llamadas a fwrite, en lugar de una escritura (y un vaciado con endl) por línea.
+// En máscaras grandes, los hilos del pool formatean bloques distintos y los bloques se escriben en
+// orden, así que el archivo es idéntico byte a byte al de la versión secuencial.
+bool generarArchivoEnmascaramiento(const char* archivoSalida, const unsigned char* datos,
+                                   const unsigned char* mascara, int offset, int n_pixels) {
+    if (offset < 0 || n_pixels < 0 || n_pixels > MAX_PIXELES_ENMASCARAMIENTO) {
+        cout << "Error: semilla o cantidad de píxeles inválida para " << archivoSalida << endl;
+        return false;
+    }
+    SpanTraza traza("generarArchivoEnmascaramiento", (size_t)n_pixels * 3);
+    FILE* out = fopen(archivoSalida, "wb");
+    if (out == nullptr) {
+        cout << "Error al crear " << archivoSalida << endl;
+        return false;
+    }
+    setvbuf(out, nullptr, _IONBF, 0);
+
+    int n_bloques = (int)thread::hardware_concurrency();
+    if (n_bloques < 1 || n_pixels < MIN_PIXELES_ENMASCARAMIENTO_PARALELO) n_bloques = 1;
+
+    // En cada ronda se formatean n_bloques bloques de a lo sumo pixelesPorBloque píxeles, cada uno
+    // en su buffer, repartidos entre los hilos del pool
+    int pixelesPorBloque = (int)(TAMANO_BUFFER_ESCRITURA / MAX_BYTES_LINEA_ENMASCARAMIENTO);
+    if (n_bloques > 1 && pixelesPorBloque > n_pixels / n_bloques + 1) {
+        pixelesPorBloque = n_pixels / n_bloques + 1;
+    }
+    size_t bytesBuffer = (size_t)pixelesPorBloque * MAX_BYTES_LINEA_ENMASCARAMIENTO + 32;
+    ContextoFormateo contexto;
+    contexto.datos = datos;
+    contexto.mascara = mascara;
+    contexto.offset = offset;
+    contexto.n_pixels = n_pixels;
+    contexto.pixelesPorBloque = pixelesPorBloque;
+    contexto.buffers = new char*[n_bloques];
+    contexto.usados = new size_t[n_bloques];
+    for (int h = 0; h < n_bloques; ++h) contexto.buffers[h] = new char[bytesBuffer];
+
+    // Primera línea: la semilla
+    int bytesSemilla = snprintf(contexto.buffers[0], 32, "%d%s", offset, SALTO_LINEA);
+    bool ok = fwrite(contexto.buffers[0], 1, (size_t)bytesSemilla, out) == (size_t)bytesSemilla;
+
+    for (int ronda = 0; ronda < n_pixels && ok; ronda += pixelesPorBloque * n_bloques) {
+        int pendientes = (n_pixels - ronda + pixelesPorBloque - 1) / pixelesPorBloque;
+        int activos = pendientes < n_bloques ? pendientes : n_bloques;
+        contexto.ronda = ronda;
+        ejecutarEnParalelo(tareaFormateo, &contexto, (size_t)activos, 2, 1);
+        // Los bloques se escriben en el orden de la máscara
+        for (int h = 0; h < activos && ok; ++h) {
+            ok = fwrite(contexto.buffers[h], 1, contexto.usados[h], out) == contexto.usados[h];
+        }
+    }
+
+    for (int h = 0; h < n_bloques; ++h) delete[] contexto.buffers[h];
+    delete[] contexto.buffers;
+    delete[] contexto.usados;
+    if (fclose(out) != 0) ok = false;
+    if (!ok) cout << "Error al escribir " << archivoSalida << endl;
+    return ok;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Formato binario de enmascaramiento
+// ---------------------------------------------------------------------------------------------
+
+// Hash de 64 bits con el algoritmo de XXH64 (cuatro acumuladores de 8 bytes por vuelta, sin
+// dependencias entre ellos, así que procesa varios GB/s en un solo hilo)
+static const unsigned long long PRIMO64_1 = 0x9E3779B185EBCA87ULL;
+static const unsigned long long PRIMO64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const unsigned long long PRIMO64_3 = 0x165667B19E3779F9ULL;
+static const unsigned long long PRIMO64_4 = 0x85EBCA77C2B2AE63ULL;
+static const unsigned long long PRIMO64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline unsigned long long rotl64(unsigned long long x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline unsigned long long leerU64(const unsigned char* p) {
+    unsigned long long v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline unsigned long long rondaHash(unsigned long long acumulador, unsigned long long entrada) {
+    acumulador += entrada * PRIMO64_2;
+    acumulador = rotl64(acumulador, 31);
+    return acumulador * PRIMO64_1;
+}
+
+static inline unsigned long long mezclarAcumulador(unsigned long long hash, unsigned long long acumulador) {
+    hash ^= rondaHash(0, acumulador);
+    return hash * PRIMO64_1 + PRIMO64_4;
+}
+
+unsigned long long hash64(const void* datos, size_t tamano, unsigned long long semilla) {
+    const unsigned char* p = (const unsigned char*)datos;
+    const unsigned char* fin = p + tamano;
+    unsigned long long hash;
+
+    if (tamano >= 32) {
+        unsigned long long v1 = semilla + PRIMO64_1 + PRIMO64_2;
+        unsigned long long v2 = semilla + PRIMO64_2;
+        unsigned long long v3 = semilla;
+        unsigned long long v4 = semilla - PRIMO64_1;
+        const unsigned char* limite = fin - 32;
+        do {
+            v1 = rondaHash(v1, leerU64(p));
+            v2 = rondaHash(v2, leerU64(p + 8));
+            v3 = rondaHash(v3, leerU64(p + 16));
+            v4 = rondaHash(v4, leerU64(p + 24));
+            p += 32;
+        } while (p <= limite);
+        hash = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        hash = mezclarAcumulador(hash, v1);
+        hash = mezclarAcumulador(hash, v2);
+        hash = mezclarAcumulador(hash, v3);
+        hash = mezclarAcumulador(hash, v4);
+    } else {
+        hash = semilla + PRIMO64_5;
+    }
+    hash += (unsigned long long)tamano;
+
+    for (; p + 8 <= fin; p += 8) {
+        hash ^= rondaHash(0, leerU64(p));
+        hash = rotl64(hash, 27) * PRIMO64_1 + PRIMO64_4;
+    }
+    if (p + 4 <= fin) {
+        hash ^= (unsigned long long)leerU32(p) * PRIMO64_1;
+        hash = rotl64(hash, 23) * PRIMO64_2 + PRIMO64_3;
+        p += 4;
+    }
+    for (; p < fin; ++p) {
+        hash ^= (*p) * PRIMO64_5;
+        hash = rotl64(hash, 11) * PRIMO64_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIMO64_2;
+    hash ^= hash >> 29;
+    hash *= PRIMO64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// El formato guarda los valores en little-endian y se usan tal cual desde la proyección
+static bool hostLittleEndian() {
+    const unsigned short uno = 1;
+    return *(const unsigned char*)&uno == 1;
+}
+
+// Escribe el archivo binario a partir de valores ya sumados (n_pixels * 3 valores de 16 bits)
+static bool escribirEnmascaramientoBinario(const char* archivoSalida, const unsigned short* valores, int seed,
+                                           int n_pixels, int width, int height) {
+    if (!hostLittleEndian()) {
+        cout << "Error: el formato binario de enmascaramiento requiere un procesador little-endian." << endl;
+        return false;
+    }
+    FILE* out = fopen(archivoSalida, "wb");
+    if (out == nullptr) {
+        cout << "Error al crear " << archivoSalida << endl;
+        return false;
+    }
+
+    size_t bytesValores = (size_t)n_pixels * 3 * sizeof(unsigned short);
+    unsigned char cabecera[TAMANO_CABECERA_ENMASCARAMIENTO];
+    memset(cabecera, 0, sizeof(cabecera));
+    memcpy(cabecera, "DMSK", 4);
+    escribirU16(cabecera + 4, 1);
+    escribirU16(cabecera + 6, 16);
+    escribirU32(cabecera + 8, (unsigned int)seed);
+    escribirU32(cabecera + 12, (unsigned int)n_pixels);
+    escribirU32(cabecera + 16, (unsigned int)width);
+    escribirU32(cabecera + 20, (unsigned int)height);
+    unsigned long long suma = hash64(valores, bytesValores, 0);
+    escribirU32(cabecera + 24, (unsigned int)suma);
+    escribirU32(cabecera + 28, (unsigned int)(suma >> 32));
+
+    bool ok = fwrite(cabecera, 1, sizeof(cabecera), out) == sizeof(cabecera) &&
+              fwrite(valores, 1, bytesValores, out) == bytesValores;
+    if (fclose(out) != 0) ok = false;
+    if (!ok) cout << "Error al escribir " << archivoSalida << endl;
+    return ok;
+}
+
+struct ContextoSumaMascara {
+    const unsigned char* datos;
+    const unsigned char* mascara;
+    unsigned short* valores;
+};
+
+static void tareaSumaMascara(void* contexto, size_t desde, size_t hasta) {
+    const ContextoSumaMascara* c = (const ContextoSumaMascara*)contexto;
+    for (size_t i = desde; i < hasta; ++i) {
+        c->valores[i] = (unsigned short)(c->datos[i] + c->mascara[i]);
+    }
+}
+
+// Igual que generarArchivoEnmascaramiento pero en formato binario; widthMascara y heightMascara solo
+// se guardan en la cabecera
+bool generarArchivoEnmascaramientoBinario(const char* archivoSalida, const unsigned char* datos,
+                                          const unsigned char* mascara, int offset, int n_pixels,
+                                          int widthMascara, int heightMascara) {
+    if (offset < 0 || n_pixels < 0 || n_pixels > MAX_PIXELES_ENMASCARAMIENTO) {
+        cout << "Error: semilla o cantidad de píxeles inválida para " << archivoSalida << endl;
+        return false;
+    }
+    size_t n_valores = (size_t)n_pixels * 3;
+    SpanTraza traza("generarArchivoEnmascaramientoBinario", n_valores);
+    unsigned short* valores = new unsigned short[n_valores];
+    ContextoSumaMascara contexto = {datos + (size_t)offset * 3, mascara, valores};
+    ejecutarEnParalelo(tareaSumaMascara, &contexto, n_valores);
+    bool ok = escribirEnmascaramientoBinario(archivoSalida, valores, offset, n_pixels, widthMascara, heightMascara);
+    delete[] valores;
+    return ok;
+}
+
+// Valida la cabecera y el hash de un archivo binario ya proyectado
+static bool validarEnmascaramientoBinario(const ArchivoMapeado &archivo, const char* nombreArchivo,
+                                          int &seed, int &n_pixels, int &width, int &height) {
+    const unsigned char* d = archivo.datos;
+    if (archivo.tamano < (size_t)TAMANO_CABECERA_ENMASCARAMIENTO || memcmp(d, "DMSK", 4) != 0) {
+        cout << "Error: " << nombreArchivo << " no es un archivo de enmascaramiento binario." << endl;
+        return false;
+    }
+    if (leerU16(d + 4) != 1 || leerU16(d + 6) != 16) {
+        cout << "Error: versión o tamaño de valor no soportado en " << nombreArchivo << endl;
+        return false;
+    }
+    if (!hostLittleEndian()) {
+        cout << "Error: el formato binario de enmascaramiento requiere un procesador little-endian." << endl;
+        return false;
+    }
+    unsigned int pixeles = leerU32(d + 12);
+    if (pixeles > (unsigned int)MAX_PIXELES_ENMASCARAMIENTO ||
+        archivo.tamano - TAMANO_CABECERA_ENMASCARAMIENTO != (size_t)pixeles * 3 * sizeof(unsigned short)) {
+        cout << "Error: el tamaño de " << nombreArchivo << " no coincide con su cabecera." << endl;
+        return false;
+    }
+    unsigned long long esperado = (unsigned long long)leerU32(d + 24) | ((unsigned long long)leerU32(d + 28) << 32);
+    if (hash64(d + TAMANO_CABECERA_ENMASCARAMIENTO, archivo.tamano - TAMANO_CABECERA_ENMASCARAMIENTO, 0) != esperado) {
+        cout << "Error: la suma de verificación de " << nombreArchivo << " no coincide." << endl;
+        return false;
+    }
+    seed = (int)leerU32(d + 8);
+    n_pixels = (int)pixeles;
+    width = (int)leerU32(d + 16);
+    height = (int)leerU32(d + 20);
+    return true;
+}
+
+bool abrirVistaEnmascaramiento(const char* nombreArchivo, VistaEnmascaramiento &vista) {
+    /*
+ * @brief Abre un archivo de enmascaramiento en cualquiera de los dos formatos. Los binarios se
+ *        proyectan y sus valores se usan en el lugar, sin copiarlos; los de texto se interpretan con
+ *        loadSeedMasking en un buffer del que la vista es dueña.
+ *
+ * @param nombreArchivo Ruta del archivo.
+ * @param vista Estructura de salida; vista.valores apunta a n_pixels * 3 valores de 16 bits.
+ * @return true si el archivo existe y es válido (en los binarios, cabecera correcta y hash coincidente).
+ *
+ * @note La vista se debe cerrar con cerrarVistaEnmascaramiento().
+ */
+    vista.valores = nullptr;
+    vista.propios = nullptr;
+    vista.width = 0;
+    vista.height = 0;
+    if (!mapearArchivo(nombreArchivo, vista.archivo)) {
+        cout << "No se pudo abrir el archivo." << endl;
+        return false;
+    }
+    if (vista.archivo.tamano < 4 || memcmp(vista.archivo.datos, "DMSK", 4) != 0) {
+        liberarMapeo(vista.archivo);
+        vista.propios = loadSeedMasking(nombreArchivo, vista.seed, vista.n_pixels);
+        vista.valores = vista.propios;
+        return vista.propios != nullptr;
+    }
+    if (!validarEnmascaramientoBinario(vista.archivo, nombreArchivo, vista.seed, vista.n_pixels,
+                                       vista.width, vista.height)) {
+        liberarMapeo(vista.archivo);
+        return false;
+    }
+    vista.valores = (const unsigned short*)(vista.archivo.datos + TAMANO_CABECERA_ENMASCARAMIENTO);
+    return true;
+}
+
+void cerrarVistaEnmascaramiento(VistaEnmascaramiento &vista) {
+    liberarMapeo(vista.archivo);
+    delete[] vista.propios;
+    vista.propios = nullptr;
+    vista.valores = nullptr;
+}
+
+// Usada por loadSeedMasking cuando el archivo empieza con "DMSK": una sola copia, sin interpretar texto
+static unsigned short* cargarEnmascaramientoBinario(const ArchivoMapeado &archivo, const char* nombreArchivo,
+                                                    int &seed, int &n_pixels) {
+    int width = 0, height = 0;
+    if (!validarEnmascaramientoBinario(archivo, nombreArchivo, seed, n_pixels, width, height)) return nullptr;
+    unsigned short* RGB = new unsigned short[(size_t)n_pixels * 3];
+    memcpy(RGB, archivo.datos + TAMANO_CABECERA_ENMASCARAMIENTO, (size_t)n_pixels * 3 * sizeof(unsigned short));
+    return RGB;
+}
+
+bool convertirEnmascaramientoTextoABinario(const char* archivoTexto, const char* archivoBinario) {
+    int seed = 0, n_pixels = 0;
+    unsigned short* valores = loadSeedMasking(archivoTexto, seed, n_pixels);
+    if (valores == nullptr) return false;
+    // El formato de texto no guarda las dimensiones de la máscara
+    bool ok = escribirEnmascaramientoBinario(archivoBinario, valores, seed, n_pixels, 0, 0);
+    delete[] valores;
+    return ok;
+}
+
+bool convertirEnmascaramientoBinarioATexto(const char* archivoBinario, const char* archivoTexto) {
+    VistaEnmascaramiento vista;
+    if (!abrirVistaEnmascaramiento(archivoBinario, vista)) return false;
+
+    FILE* out = fopen(archivoTexto, "wb");
+    if (out == nullptr) {
+        cout << "Error al crear " << archivoTexto << endl;
+        cerrarVistaEnmascaramiento(vista);
+        return false;
+    }
+    setvbuf(out, nullptr, _IONBF, 0);
+
+    const int pixelesPorBloque = (int)(TAMANO_BUFFER_ESCRITURA / MAX_BYTES_LINEA_ENMASCARAMIENTO);
+    char* buffer = new char[(size_t)pixelesPorBloque * MAX_BYTES_LINEA_ENMASCARAMIENTO + 32];
+    int usados = snprintf(buffer, 32, "%d%s", vista.seed, SALTO_LINEA);
+    bool ok = fwrite(buffer, 1, (size_t)usados, out) == (size_t)usados;
+
+    for (int desde = 0; desde < vista.n_pixels && ok; desde += pixelesPorBloque) {
+        int hasta = desde + pixelesPorBloque < vista.n_pixels ? desde + pixelesPorBloque : vista.n_pixels;
+        char* p = buffer;
+        for (int i = desde * 3; i < hasta * 3 && ok; ++i) {
+            unsigned short v = vista.valores[i];
+            if (v > 510) {
+                cout << "Error: valor fuera de rango en " << archivoBinario << endl;
+                ok = false;
+                break;
+            }
+            memcpy(p, tablaDigitos.texto[v], 4);
+            p += tablaDigitos.longitud[v];
+            if (i % 3 == 2) {
+                memcpy(p, SALTO_LINEA, LONGITUD_SALTO_LINEA);
+                p += LONGITUD_SALTO_LINEA;
+            } else {
+                *p++ = ' ';
+            }
+        }
+        if (ok) ok = fwrite(buffer, 1, (size_t)(p - buffer), out) == (size_t)(p - buffer);
+    }
+
+    delete[] buffer;
+    if (fclose(out) != 0) ok = false;
+    cerrarVistaEnmascaramiento(vista);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Informe de diferencias
+// ---------------------------------------------------------------------------------------------
+
+// Cada kernel compara hasta 64 bytes y devuelve una máscara con un bit encendido por byte distinto
+typedef unsigned long long (*KernelMascaraDiferencias)(const unsigned char*, const unsigned char*, int);
+
+static unsigned long long mascaraDiferencias_Escalar(const unsigned char* a, const unsigned char* b, int n) {
+    unsigned long long m = 0;
+    for (int i = 0; i < n; ++i) {
+        if (a[i] != b[i]) m |= 1ULL << i;
+    }
+    return m;
+}
+
+#ifdef DESAFIO_X86
+OBJETIVO_CPU("sse2")
+static unsigned long long mascaraDiferencias_SSE2(const unsigned char* a, const unsigned char* b, int n) {
+    if (n < 64) return mascaraDiferencias_Escalar(a, b, n);
+    unsigned long long iguales = 0;
+    for (int i = 0; i < 4; ++i) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i * 16));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + i * 16));
+        iguales |= (unsigned long long)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) << (i * 16);
+    }
+    return ~iguales;
+}
+
+OBJETIVO_CPU("avx2")
+static unsigned long long mascaraDiferencias_AVX2(const unsigned char* a, const unsigned char* b, int n) {
+    if (n < 64) return mascaraDiferencias_Escalar(a, b, n);
+    __m256i x0 = _mm256_loadu_si256((const __m256i*)a);
+    __m256i x1 = _mm256_loadu_si256((const __m256i*)(a + 32));
+    __m256i y0 = _mm256_loadu_si256((const __m256i*)b);
+    __m256i y1 = _mm256_loadu_si256((const __m256i*)(b + 32));
+    unsigned long long iguales = (unsigned long long)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x0, y0)) |
+                                 (unsigned long long)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x1, y1)) << 32;
+    _mm256_zeroupper();
+    return ~iguales;
+}
+
+OBJETIVO_CPU("avx512f,avx512bw")
+static unsigned long long mascaraDiferencias_AVX512(const unsigned char* a, const unsigned char* b, int n) {
+    // Los bloques incompletos se cargan con máscara, así que no hace falta un camino escalar
+    __mmask64 m = n >= 64 ? ~0ULL : ~0ULL >> (64 - n);
+    __m512i x = _mm512_maskz_loadu_epi8(m, a);
+    __m512i y = _mm512_maskz_loadu_epi8(m, b);
+    unsigned long long distintos = _mm512_cmpneq_epu8_mask(x, y);
+    _mm256_zeroupper();
+    return distintos;
+}
+#endif
+
+static KernelMascaraDiferencias seleccionarKernelMascaraDiferencias() {
+#ifdef DESAFIO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) return mascaraDiferencias_AVX512;
+    if (__builtin_cpu_supports("avx2")) return mascaraDiferencias_AVX2;
+    if (__builtin_cpu_supports("sse2")) return mascaraDiferencias_SSE2;
+#endif
+    return mascaraDiferencias_Escalar;
+}
+
+static const KernelMascaraDiferencias kernelMascaraDiferencias = seleccionarKernelMascaraDiferencias();
+
+// mascaraCanal[c][f]: bits de un bloque de 64 bytes que caen en el canal c cuando el bloque empieza
+// en un byte de la fila con (posición % 3) == f
+struct MascarasCanal {
+    unsigned long long m[3][3];
+};
+
+static MascarasCanal construirMascarasCanal() {
+    MascarasCanal t;
+    for (int c = 0; c < 3; ++c) {
+        for (int f = 0; f < 3; ++f) {
+            t.m[c][f] = 0;
+            for (int j = 0; j < 64; ++j) {
+                if ((f + j) % 3 == c) t.m[c][f] |= 1ULL << j;
+            }
+        }
+    }
+    return t;
+}
+
+static const MascarasCanal mascarasCanal = construirMascarasCanal();
+
+// Acumula en reporte las diferencias de una franja de a lo sumo TAMANO_BLOQUE_DIFERENCIAS filas que
+// empieza en la fila y0, es decir, de una fila de bloques del mapa de calor
+static void diferenciasFranja(const Imagen &franja1, const Imagen &franja2, int y0, ReporteDiferencias &reporte) {
+    size_t bytesFila = (size_t)franja1.width * 3;
+    const size_t bytesBloque = TAMANO_BLOQUE_DIFERENCIAS * 3;
+    int* calorFila = reporte.mapaCalor + (y0 / TAMANO_BLOQUE_DIFERENCIAS) * reporte.bloquesX;
+    for (int y = 0; y < franja1.height; ++y) {
+        const unsigned char* fila1 = franja1.fila(y);
+        const unsigned char* fila2 = franja2.fila(y);
+
+        int bx = 0;
+        for (size_t inicioBloque = 0; inicioBloque < bytesFila; inicioBloque += bytesBloque, ++bx) {
+            size_t finBloque = inicioBloque + bytesBloque < bytesFila ? inicioBloque + bytesBloque : bytesFila;
+            for (size_t o = inicioBloque; o < finBloque; o += 64) {
+                int n = finBloque - o < 64 ? (int)(finBloque - o) : 64;
+                unsigned long long m = kernelMascaraDiferencias(fila1 + o, fila2 + o, n);
+                if (m == 0) continue;
+
+                int cantidad = __builtin_popcountll(m);
+                reporte.bytesDistintos += cantidad;
+                calorFila[bx] += cantidad;
+                int fase = (int)(o % 3);
+                for (int c = 0; c < 3; ++c) {
+                    reporte.bytesDistintosCanal[c] += __builtin_popcountll(m & mascarasCanal.m[c][fase]);
+                }
+                if (reporte.primeraY < 0) {
+                    reporte.primeraX = (int)((o + __builtin_ctzll(m)) / 3);
+                    reporte.primeraY = y0 + y;
+                }
+                reporte.ultimaX = (int)((o + 63 - __builtin_clzll(m)) / 3);
+                reporte.ultimaY = y0 + y;
+            }
+        }
+    }
+}
+
+void calcularDiferencias(const Imagen &img1, const Imagen &img2, ReporteDiferencias &reporte) {
+    /*
+ * @brief Compara dos imágenes RGB del mismo tamaño (o vistas, con cualquier paso) y arma el informe
+ *        de diferencias.
+ *
+ * Recorre las imágenes por franjas de TAMANO_BLOQUE_DIFERENCIAS filas, una por fila de bloques del
+ * mapa de calor, y cada fila por tramos de un bloque (64 píxeles = 192 bytes = 3 bloques de 64
+ * bytes). Cada bloque de 64 bytes se reduce con SIMD a una máscara de bytes distintos, de la que
+ * salen con popcount el total, los contadores por canal y el del bloque, y con ctz/clz la primera y
+ * la última diferencia. Las zonas iguales cuestan una comparación por bloque.
+ *
+ * @note El informe se libera con liberarReporteDiferencias().
+ */
+    int width = img1.width;
+    int height = img1.height;
+    SpanTraza traza("calcularDiferencias", (size_t)width * height * 3 * 2);
+    reporte.width = width;
+    reporte.height = height;
+    reporte.bytesDistintos = 0;
+    reporte.bytesDistintosCanal[0] = reporte.bytesDistintosCanal[1] = reporte.bytesDistintosCanal[2] = 0;
+    reporte.primeraX = reporte.primeraY = reporte.ultimaX = reporte.ultimaY = -1;
+    reporte.bloquesX = (width + TAMANO_BLOQUE_DIFERENCIAS - 1) / TAMANO_BLOQUE_DIFERENCIAS;
+    reporte.bloquesY = (height + TAMANO_BLOQUE_DIFERENCIAS - 1) / TAMANO_BLOQUE_DIFERENCIAS;
+    int n_bloques = reporte.bloquesX * reporte.bloquesY;
+    reporte.mapaCalor = new int[n_bloques > 0 ? n_bloques : 1];
+    for (int i = 0; i < n_bloques; ++i) reporte.mapaCalor[i] = 0;
+    if (img1.vacia() || img2.vacia() || img2.width != width || img2.height != height) return;
+
+    for (int y0 = 0; y0 < height; y0 += TAMANO_BLOQUE_DIFERENCIAS) {
+        int nFilas = height - y0 < TAMANO_BLOQUE_DIFERENCIAS ? height - y0 : TAMANO_BLOQUE_DIFERENCIAS;
+        diferenciasFranja(img1.franja(y0, nFilas), img2.franja(y0, nFilas), y0, reporte);
+    }
+}
+
+// Lo mismo para dos buffers RGB compactos de width x height píxeles
+void calcularDiferencias(const unsigned char* img1, const unsigned char* img2, int width, int height,
+                         ReporteDiferencias &reporte) {
+    calcularDiferencias(Imagen::vistaDe(img1, width, height), Imagen::vistaDe(img2, width, height), reporte);
+}
+
+void imprimirReporteDiferencias(const ReporteDiferencias &reporte) {
+    long long total = (long long)reporte.width * reporte.height * 3;
+    cout << "Bytes distintos: " << reporte.bytesDistintos << " de " << total << endl;
+    if (reporte.bytesDistintos == 0) return;
+    cout << "  Por canal (R, G, B): " << reporte.bytesDistintosCanal[0] << ", "
+         << reporte.bytesDistintosCanal[1] << ", " << reporte.bytesDistintosCanal[2] << endl;
+    cout << "  Primera diferencia: (" << reporte.primeraX << ", " << reporte.primeraY << ")" << endl;
+    cout << "  Última diferencia: (" << reporte.ultimaX << ", " << reporte.ultimaY << ")" << endl;
+
+    // Mapa de calor: un carácter por bloque, de '.' (sin diferencias) a '#' (todos sus bytes distintos)
+    const char niveles[] = ".:-=+*%#";
+    cout << "  Mapa de bloques de " << TAMANO_BLOQUE_DIFERENCIAS << "x" << TAMANO_BLOQUE_DIFERENCIAS
+         << " píxeles:" << endl;
+    for (int by = 0; by < reporte.bloquesY; ++by) {
+        string linea = "  ";
+        for (int bx = 0; bx < reporte.bloquesX; ++bx) {
+            int valor = reporte.mapaCalor[by * reporte.bloquesX + bx];
+            int nivel = 0;
+            if (valor > 0) {
+                int capacidad = TAMANO_BLOQUE_DIFERENCIAS * TAMANO_BLOQUE_DIFERENCIAS * 3;
+                nivel = 1 + (int)((long long)valor * 6 / capacidad);
+                if (nivel > 7) nivel = 7;
+            }
+            linea += niveles[nivel];
+        }
+        cout << linea << endl;
+    }
+}
+
+void liberarReporteDiferencias(ReporteDiferencias &reporte) {
+    delete[] reporte.mapaCalor;
+    reporte.mapaCalor = nullptr;
+}
+
+struct ContextoComparacionBMP {
+    const VistaBMP* a;
+    const VistaBMP* b;
+    atomic<bool> distintas;
+};
+
+// Compara las filas [desde, hasta) de dos vistas. Dos BMP de 24 bits se comparan directamente en el
+// archivo proyectado (sin el relleno de cada fila); si alguno es de 32 bits, las filas se pasan a RGB
+// antes, para no mirar el cuarto byte de cada píxel, que en BI_RGB no se usa
+static void compararFilasBMP(void* contexto, size_t desde, size_t hasta) {
+    ContextoComparacionBMP* c = (ContextoComparacionBMP*)contexto;
+    const VistaBMP* a = c->a;
+    const VistaBMP* b = c->b;
+    if (a->bytesPorPixel == 3 && b->bytesPorPixel == 3) {
+        for (size_t y = desde; y < hasta && !c->distintas.load(memory_order_relaxed); ++y) {
+            if (memcmp(a->primeraFila + (ptrdiff_t)y * a->paso, b->primeraFila + (ptrdiff_t)y * b->paso,
+                       (size_t)a->width * 3) != 0) {
+                c->distintas.store(true, memory_order_relaxed);
+            }
+        }
+        return;
+    }
+    unsigned char* filaA = new unsigned char[(size_t)a->width * 3 + 16];
+    unsigned char* filaB = new unsigned char[(size_t)a->width * 3 + 16];
+    for (size_t y = desde; y < hasta && !c->distintas.load(memory_order_relaxed); ++y) {
+        kernelFilaBGR(a->primeraFila + (ptrdiff_t)y * a->paso, filaA, a->width, a->bytesPorPixel);
+        kernelFilaBGR(b->primeraFila + (ptrdiff_t)y * b->paso, filaB, b->width, b->bytesPorPixel);
+        if (memcmp(filaA, filaB, (size_t)a->width * 3) != 0) c->distintas.store(true, memory_order_relaxed);
+    }
+    delete[] filaA;
+    delete[] filaB;
+}
+
+// Decodifica ambas imágenes y arma el informe; no hace nada si las dimensiones no coinciden
+static void informarDiferencias(QString archivo1, QString archivo2, ReporteDiferencias &reporte) {
+    int w1 = 0, h1 = 0, w2 = 0, h2 = 0;
+    unsigned char* img1 = loadPixels(archivo1, w1, h1);
+    unsigned char* img2 = loadPixels(archivo2, w2, h2);
+    if (img1 != nullptr && img2 != nullptr && w1 == w2 && h1 == h2) {
+        calcularDiferencias(img1, img2, w1, h1, reporte);
+    }
+    liberarBufferPixeles(img1);
+    liberarBufferPixeles(img2);
+}
+
+// Comparación original: decodifica ambos archivos con QImage (formatos que el lector nativo no soporta)
+static bool compararImagenesQImage(QString archivo1, QString archivo2) {
+    QImage img1(archivo1);
+    QImage img2(archivo2);
+    if (img1.size() != img2.size()) return false;
+    img1 = img1.convertToFormat(QImage::Format_RGB888);
+    img2 = img2.convertToFormat(QImage::Format_RGB888);
+
+    for (int y = 0; y < img1.height(); ++y) {
+        const uchar* line1 = img1.scanLine(y);
+        const uchar* line2 = img2.scanLine(y);
+        if (memcmp(line1, line2, img1.width() * 3) != 0) return false;
+    }
+    return true;
+}
+
+bool compararImagenes(QString archivo1, QString archivo2, ReporteDiferencias* reporte) {
+    /*
+ * @brief Indica si dos imágenes tienen los mismos píxeles RGB.
+ *
+ * Compara por niveles, del más barato al más caro:
+ *  1. Las cabeceras: si el ancho o el alto difieren no se mira ningún píxel.
+ *  2. Una comparación exacta en paralelo, fila por fila, de los bytes de color. Dos BMP de 24 bits
+ *     se comparan con memcmp directamente sobre los archivos proyectados; si hay uno de 32 bits, las
+ *     filas se pasan antes a RGB, así que el cuarto byte de cada píxel no cuenta.
+ * Si alguno de los archivos no es un BMP que el lector nativo entienda, se usa QImage.
+ *
+ * @param reporte Si no es nullptr y las imágenes difieren con las mismas dimensiones, se llena con
+ *                el informe de diferencias (que luego se libera con liberarReporteDiferencias()).
+ *                Si no se llena, reporte->mapaCalor queda en nullptr.
+ * @return true si ambas imágenes tienen las mismas dimensiones y los mismos píxeles.
+ */
+    SpanTraza traza("compararImagenes");
+    if (reporte != nullptr) reporte->mapaCalor = nullptr;
+
+    VistaBMP a, b;
+    if (!abrirVistaBMP(archivo1.toLocal8Bit().constData(), a)) {
+        bool iguales = compararImagenesQImage(archivo1, archivo2);
+        if (!iguales && reporte != nullptr) informarDiferencias(archivo1, archivo2, *reporte);
+        return iguales;
+    }
+    if (!abrirVistaBMP(archivo2.toLocal8Bit().constData(), b)) {
+        cerrarVistaBMP(a);
+        bool iguales = compararImagenesQImage(archivo1, archivo2);
+        if (!iguales && reporte != nullptr) informarDiferencias(archivo1, archivo2, *reporte);
+        return iguales;
+    }
+
+    traza.bytes = (size_t)a.width * a.height * a.bytesPorPixel + (size_t)b.width * b.height * b.bytesPorPixel;
+    bool iguales;
+    if (a.width != b.width || a.height != b.height) {
+        iguales = false;
+    } else {
+        // El reparto es por filas: el umbral del pool se traduce de bytes a filas
+        ContextoComparacionBMP contexto;
+        contexto.a = &a;
+        contexto.b = &b;
+        contexto.distintas = false;
+        size_t bytesFila = (size_t)a.width * 3;
+        ejecutarEnParalelo(compararFilasBMP, &contexto, (size_t)a.height, MIN_BYTES_PARALELO / bytesFila + 1, 1);
+        iguales = !contexto.distintas.load();
+    }
+
+    cerrarVistaBMP(a);
+    cerrarVistaBMP(b);
+    if (!iguales && reporte != nullptr) informarDiferencias(archivo1, archivo2, *reporte);
+    return iguales;
+}
+
+// Proyecta un archivo para compararlo; los archivos vacíos no se pueden proyectar y quedan como
+// un rango vacío
+static bool abrirParaComparar(const char* ruta, ArchivoMapeado &archivo, bool &mapeado) {
+    mapeado = mapearArchivo(ruta, archivo);
+    if (mapeado) return true;
+    FILE* f = fopen(ruta, "rb");
+    if (f == nullptr) return false;
+    bool vacio = fgetc(f) == EOF;
+    fclose(f);
+    archivo.datos = nullptr;
+    archivo.tamano = 0;
+    return vacio;
+}
+
+// Lee la siguiente palabra (secuencia sin espacios) desde p; deja p justo después de ella
+static bool siguientePalabra(const char* &p, const char* fin, const char* &inicio, size_t &longitud) {
+    p = saltarEspacios(p, fin);
+    if (p == fin) return false;
+    inicio = p;
+    while (p < fin && *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t') ++p;
+    longitud = (size_t)(p - inicio);
+    return true;
+}
+
+// Compara ambos archivos palabra por palabra; las que son números enteros se comparan por valor
+static bool compararNumerico(const char* p1, const char* fin1, const char* p2, const char* fin2) {
+    const char* palabra1;
+    const char* palabra2;
+    size_t longitud1, longitud2;
+    while (true) {
+        bool hay1 = siguientePalabra(p1, fin1, palabra1, longitud1);
+        bool hay2 = siguientePalabra(p2, fin2, palabra2, longitud2);
+        if (!hay1 || !hay2) return hay1 == hay2;
+
+        if (longitud1 == longitud2 && memcmp(palabra1, palabra2, longitud1) == 0) continue;
+
+        long long valor1, valor2;
+        from_chars_result r1 = from_chars(palabra1, palabra1 + longitud1, valor1);
+        from_chars_result r2 = from_chars(palabra2, palabra2 + longitud2, valor2);
+        bool numero1 = r1.ec == errc() && r1.ptr == palabra1 + longitud1;
+        bool numero2 = r2.ec == errc() && r2.ptr == palabra2 + longitud2;
+        if (!numero1 || !numero2 || valor1 != valor2) return false;
+    }
+}
+
+bool compararArchivos(const char* archivo1, const char* archivo2, ModoComparacion modo) {
+    /*
+ * @brief Compara dos archivos de texto (por ejemplo, dos archivos de enmascaramiento).
+ *
+ * Ambos archivos se proyectan en memoria. Si son idénticos byte a byte, alcanza con un memcmp
+ * (vectorizado por la biblioteca de C). Si no lo son:
+ *  - COMPARAR_BYTES devuelve false.
+ *  - COMPARAR_NUMERICO los recorre a la par ignorando espacios y saltos de línea (\n o \r\n) y
+ *    compara los números por valor, así que un archivo escrito en Windows coincide con su versión
+ *    de Linux.
+ *
+ * @return true si los archivos coinciden según el modo; false si difieren o no se pueden abrir.
+ */
+    SpanTraza traza("compararArchivos");
+    ArchivoMapeado a, b;
+    bool mapeadoA, mapeadoB;
+    if (!abrirParaComparar(archivo1, a, mapeadoA)) return false;
+    if (!abrirParaComparar(archivo2, b, mapeadoB)) {
+        if (mapeadoA) liberarMapeo(a);
+        return false;
+    }
+    traza.bytes = a.tamano + b.tamano;
+
+    bool iguales = a.tamano == b.tamano && (a.tamano == 0 || memcmp(a.datos, b.datos, a.tamano) == 0);
+    if (!iguales && modo == COMPARAR_NUMERICO) {
+        const char* p1 = (const char*)a.datos;
+        const char* p2 = (const char*)b.datos;
+        iguales = compararNumerico(p1, p1 + a.tamano, p2, p2 + b.tamano);
+    }
+
+    if (mapeadoA) liberarMapeo(a);
+    if (mapeadoB) liberarMapeo(b);
+    return iguales;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Inferencia de transformaciones
+// ---------------------------------------------------------------------------------------------
+
+// Candidatos para cada paso. Las rotaciones a la izquierda no se prueban aparte: rotar n bits a la
+// izquierda es lo mismo que rotar 8 - n a la derecha. Los desplazamientos van al final para que, si
+// los bits conocidos no alcanzan para distinguirlos, se prefiera una operación que no pierde bits.
+const int N_CANDIDATOS_INFERENCIA = 22;
+
+static OperacionByte candidatoInferencia(int c) {
+    OperacionByte op;
+    op.imagen = nullptr;
+    if (c == 0) {
+        op.tipo = OP_XOR_IMAGEN;
+        op.parametro = 0;
+    } else if (c <= 7) {
+        op.tipo = OP_ROTAR_DER;
+        op.parametro = c;
+    } else if (c <= 14) {
+        op.tipo = OP_DESPLAZAR_IZQ;
+        op.parametro = c - 7;
+    } else {
+        op.tipo = OP_DESPLAZAR_DER;
+        op.parametro = c - 14;
+    }
+    return op;
+}
+
+static const char* describirOperacion(const OperacionByte &op) {
+    switch (op.tipo) {
+    case OP_XOR_IMAGEN:    return "XOR con I_M";
+    case OP_XOR_CONSTANTE: return "XOR con una constante";
+    case OP_ROTAR_IZQ:     return "rotación a la izquierda";
+    case OP_ROTAR_DER:     return "rotación a la derecha";
+    case OP_DESPLAZAR_IZQ: return "desplazamiento a la izquierda";
+    case OP_DESPLAZAR_DER: return "desplazamiento a la derecha";
+    }
+    return "";
+}
+
+// Aplica un paso (hacia adelante) a un byte; xorImagen es el byte de I_M en esa posición
+static inline unsigned char aplicarPaso(const OperacionByte &op, unsigned char x, unsigned char xorImagen) {
+    switch (op.tipo) {
+    case OP_XOR_IMAGEN:    return x ^ xorImagen;
+    case OP_XOR_CONSTANTE: return x ^ (unsigned char)op.parametro;
+    case OP_ROTAR_IZQ:     return rotarByteIzquierda(x, op.parametro);
+    case OP_ROTAR_DER:     return rotarByteIzquierda(x, 8 - op.parametro);
+    case OP_DESPLAZAR_IZQ: return (unsigned char)(x << op.parametro);
+    case OP_DESPLAZAR_DER: return (unsigned char)(x >> op.parametro);
+    }
+    return x;
+}
+
+// Deshace un paso sobre un byte cuyos bits conocidos indica *conocidos. Los desplazamientos pierden
+// bits: esos quedan marcados como desconocidos en lugar de inventarles un valor.
+static inline void deshacerPaso(const OperacionByte &op, unsigned char &valor, unsigned char &conocidos,
+                                unsigned char xorImagen) {
+    switch (op.tipo) {
+    case OP_XOR_IMAGEN:
+        valor ^= xorImagen;
+        break;
+    case OP_XOR_CONSTANTE:
+        valor ^= (unsigned char)op.parametro;
+        break;
+    case OP_ROTAR_IZQ:
+        valor = rotarByteIzquierda(valor, 8 - op.parametro);
+        conocidos = rotarByteIzquierda(conocidos, 8 - op.parametro);
+        break;
+    case OP_ROTAR_DER:
+        valor = rotarByteIzquierda(valor, op.parametro);
+        conocidos = rotarByteIzquierda(conocidos, op.parametro);
+        break;
+    case OP_DESPLAZAR_IZQ:
+        valor = (unsigned char)(valor >> op.parametro);
+        conocidos = (unsigned char)(conocidos >> op.parametro);
+        break;
+    case OP_DESPLAZAR_DER:
+        valor = (unsigned char)(valor << op.parametro);
+        conocidos = (unsigned char)(conocidos << op.parametro);
+        break;
+    }
+}
+
+// Tabla de los candidatos, construida una sola vez para los kernels de identificación
+struct TablaCandidatos {
+    OperacionByte op[N_CANDIDATOS_INFERENCIA];
+};
+
+static TablaCandidatos construirTablaCandidatos() {
+    TablaCandidatos t;
+    for (int c = 0; c < N_CANDIDATOS_INFERENCIA; ++c) t.op[c] = candidatoInferencia(c);
+    return t;
+}
+
+static const TablaCandidatos tablaCandidatos = construirTablaCandidatos();
+
+// Cada kernel prueba a la vez todos los candidatos vivos (un bit por candidato en vivos) sobre n
+// bytes de la ventana y devuelve los que siguen vivos. Un candidato se descarta en cuanto falla y
+// el recorrido termina si no queda ninguno; cuando queda uno solo, cada bloque cuesta una prueba.
+typedef unsigned int (*KernelCandidatos)(const unsigned char*, const unsigned char*, const unsigned char*,
+                                         const unsigned char*, size_t, unsigned int);
+
+static unsigned int probarCandidatos_Escalar(const unsigned char* anterior, const unsigned char* posterior,
+                                             const unsigned char* conocidos, const unsigned char* xorImagen,
+                                             size_t n, unsigned int vivos) {
+    for (size_t i = 0; i < n && vivos != 0; ++i) {
+        for (unsigned int pendientes = vivos; pendientes != 0; pendientes &= pendientes - 1) {
+            int c = __builtin_ctz(pendientes);
+            if ((aplicarPaso(tablaCandidatos.op[c], anterior[i], xorImagen[i]) ^ posterior[i]) & conocidos[i]) {
+                vivos &= ~(1u << c);
+            }
+        }
+    }
+    return vivos;
+}
+
+#ifdef DESAFIO_X86
+// Paso aplicado a 16 bytes: los desplazamientos de 16 bits se enmascaran para que no crucen bytes
+OBJETIVO_CPU("sse2")
+static inline __m128i aplicarPaso_SSE2(const OperacionByte &op, __m128i x, __m128i xorImagen) {
+    int izquierda;
+    switch (op.tipo) {
+    case OP_XOR_IMAGEN:
+        return _mm_xor_si128(x, xorImagen);
+    case OP_ROTAR_IZQ:
+    case OP_ROTAR_DER:
+        izquierda = op.tipo == OP_ROTAR_IZQ ? op.parametro : 8 - op.parametro;
+        return _mm_or_si128(
+            _mm_and_si128(_mm_sll_epi16(x, _mm_cvtsi32_si128(izquierda)), _mm_set1_epi8((char)(0xFF << izquierda))),
+            _mm_and_si128(_mm_srl_epi16(x, _mm_cvtsi32_si128(8 - izquierda)), _mm_set1_epi8((char)(0xFF >> (8 - izquierda)))));
+    case OP_DESPLAZAR_IZQ:
+        return _mm_and_si128(_mm_sll_epi16(x, _mm_cvtsi32_si128(op.parametro)), _mm_set1_epi8((char)(0xFF << op.parametro)));
+    case OP_DESPLAZAR_DER:
+        return _mm_and_si128(_mm_srl_epi16(x, _mm_cvtsi32_si128(op.parametro)), _mm_set1_epi8((char)(0xFF >> op.parametro)));
+    case OP_XOR_CONSTANTE:
+        return _mm_xor_si128(x, _mm_set1_epi8((char)op.parametro));
+    }
+    return x;
+}
+
+OBJETIVO_CPU("sse2")
+static unsigned int probarCandidatos_SSE2(const unsigned char* anterior, const unsigned char* posterior,
+                                          const unsigned char* conocidos, const unsigned char* xorImagen,
+                                          size_t n, unsigned int vivos) {
+    size_t i = 0;
+    for (; i + 16 <= n && vivos != 0; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(anterior + i));
+        __m128i p = _mm_loadu_si128((const __m128i*)(posterior + i));
+        __m128i k = _mm_loadu_si128((const __m128i*)(conocidos + i));
+        __m128i m = _mm_loadu_si128((const __m128i*)(xorImagen + i));
+        for (unsigned int pendientes = vivos; pendientes != 0; pendientes &= pendientes - 1) {
+            int c = __builtin_ctz(pendientes);
+            __m128i diferencia = _mm_and_si128(_mm_xor_si128(aplicarPaso_SSE2(tablaCandidatos.op[c], a, m), p), k);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(diferencia, _mm_setzero_si128())) != 0xFFFF) vivos &= ~(1u << c);
+        }
+    }
+    return probarCandidatos_Escalar(anterior + i, posterior + i, conocidos + i, xorImagen + i, n - i, vivos);
+}
+
+OBJETIVO_CPU("avx2")
+static inline __m256i aplicarPaso_AVX2(const OperacionByte &op, __m256i x, __m256i xorImagen) {
+    int izquierda;
+    switch (op.tipo) {
+    case OP_XOR_IMAGEN:
+        return _mm256_xor_si256(x, xorImagen);
+    case OP_ROTAR_IZQ:
+    case OP_ROTAR_DER:
+        izquierda = op.tipo == OP_ROTAR_IZQ ? op.parametro : 8 - op.parametro;
+        return _mm256_or_si256(
+            _mm256_and_si256(_mm256_sll_epi16(x, _mm_cvtsi32_si128(izquierda)), _mm256_set1_epi8((char)(0xFF << izquierda))),
+            _mm256_and_si256(_mm256_srl_epi16(x, _mm_cvtsi32_si128(8 - izquierda)), _mm256_set1_epi8((char)(0xFF >> (8 - izquierda)))));
+    case OP_DESPLAZAR_IZQ:
+        return _mm256_and_si256(_mm256_sll_epi16(x, _mm_cvtsi32_si128(op.parametro)), _mm256_set1_epi8((char)(0xFF << op.parametro)));
+    case OP_DESPLAZAR_DER:
+        return _mm256_and_si256(_mm256_srl_epi16(x, _mm_cvtsi32_si128(op.parametro)), _mm256_set1_epi8((char)(0xFF >> op.parametro)));
+    case OP_XOR_CONSTANTE:
+        return _mm256_xor_si256(x, _mm256_set1_epi8((char)op.parametro));
+    }
+    return x;
+}
+
+OBJETIVO_CPU("avx2")
+static unsigned int probarCandidatos_AVX2(const unsigned char* anterior, const unsigned char* posterior,
+                                          const unsigned char* conocidos, const unsigned char* xorImagen,
+                                          size_t n, unsigned int vivos) {
+    size_t i = 0;
+    for (; i + 32 <= n && vivos != 0; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(anterior + i));
+        __m256i p = _mm256_loadu_si256((const __m256i*)(posterior + i));
+        __m256i k = _mm256_loadu_si256((const __m256i*)(conocidos + i));
+        __m256i m = _mm256_loadu_si256((const __m256i*)(xorImagen + i));
+        for (unsigned int pendientes = vivos; pendientes != 0; pendientes &= pendientes - 1) {
+            int c = __builtin_ctz(pendientes);
+            __m256i diferencia = _mm256_and_si256(_mm256_xor_si256(aplicarPaso_AVX2(tablaCandidatos.op[c], a, m), p), k);
+            if (!_mm256_testz_si256(diferencia, diferencia)) vivos &= ~(1u << c);
+        }
+    }
+    _mm256_zeroupper();
+    return probarCandidatos_Escalar(anterior + i, posterior + i, conocidos + i, xorImagen + i, n - i, vivos);
+}
+#endif
+
+static KernelCandidatos seleccionarKernelCandidatos() {
+#ifdef DESAFIO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return probarCandidatos_AVX2;
+    if (__builtin_cpu_supports("sse2")) return probarCandidatos_SSE2;
+#endif
+    return probarCandidatos_Escalar;
+}
+
+static const KernelCandidatos kernelCandidatos = seleccionarKernelCandidatos();
+
+// Prueba los candidatos sobre la ventana: anterior es la imagen antes del paso (S - M), posterior y
+// conocidos la imagen después del paso proyectada desde I_D. Devuelve el primer candidato que cumple
+// en toda la ventana (o -1) y en sobrevivientes cuántos cumplen.
+static int identificarPaso(const unsigned char* anterior, const unsigned char* posterior,
+                           const unsigned char* conocidos, const unsigned char* xorImagen, size_t n,
+                           int &sobrevivientes) {
+    unsigned int vivos = kernelCandidatos(anterior, posterior, conocidos, xorImagen, n,
+                                          (1u << N_CANDIDATOS_INFERENCIA) - 1);
+    sobrevivientes = __builtin_popcount(vivos);
+    return vivos != 0 ? __builtin_ctz(vivos) : -1;
+}
+
+bool inferirTransformaciones(const unsigned char* imagenFinal, const unsigned char* imagenXOR, size_t dataSize,
+                             const unsigned char* mascara, size_t tamanoMascara,
+                             const char* const* archivosEnmascaramiento, int n_archivos,
+                             CadenaTransformaciones &inversa) {
+    /*
+ * @brief Deduce qué operación se aplicó en cada paso y arma la cadena que deshace todos los pasos.
+ *
+ * Cada archivo de enmascaramiento (de texto o binario; los binarios se leen desde la proyección, sin
+ * copiarlos) fija, dentro de su ventana, la imagen antes de su paso:
+ * P[seed + k] = S[k] - M[k]. Los pasos se resuelven del último al primero. Para el paso k + 1 se
+ * proyecta la ventana de I_D hacia atrás con las inversas ya identificadas (llevando qué bits siguen
+ * siendo conocidos) y se busca el candidato que, aplicado a P, reproduce esos bits. Cada candidato
+ * cuesta O(tamaño de la máscara), nunca O(tamaño de la imagen).
+ *
+ * @param imagenFinal I_D.
+ * @param imagenXOR I_M, del mismo tamaño que I_D.
+ * @param mascara Píxeles de M (tamanoMascara bytes).
+ * @param inversa Cadena de salida, sin compilar: aplicada a I_D reconstruye I_O. Los bits perdidos
+ *        por un desplazamiento quedan en cero.
+ * @return false si algún archivo no se pudo leer, no es consistente con M o ningún candidato cumple.
+ */
+    SpanTraza traza("inferirTransformaciones", dataSize);
+    iniciarCadena(inversa);
+    OperacionByte* pasos = new OperacionByte[n_archivos > 0 ? n_archivos : 1];
+    bool ok = true;
+
+    for (int k = n_archivos - 1; k >= 0 && ok; --k) {
+        VistaEnmascaramiento vista;
+        if (!abrirVistaEnmascaramiento(archivosEnmascaramiento[k], vista)) {
+            ok = false;
+            break;
+        }
+        int seed = vista.seed;
+        const unsigned short* valores = vista.valores;
+        size_t n = (size_t)vista.n_pixels * 3;
+        if (seed < 0 || n > tamanoMascara || (size_t)seed * 3 + n > dataSize) {
+            cout << "Error: la ventana de " << archivosEnmascaramiento[k] << " no entra en la imagen." << endl;
+            cerrarVistaEnmascaramiento(vista);
+            ok = false;
+            break;
+        }
+
+        size_t inicio = (size_t)seed * 3;
+        unsigned char* anterior = new unsigned char[n > 0 ? n : 1];
+        unsigned char* posterior = new unsigned char[n > 0 ? n : 1];
+        unsigned char* conocidos = new unsigned char[n > 0 ? n : 1];
+        for (size_t i = 0; i < n && ok; ++i) {
+            int valor = (int)valores[i] - mascara[i];
+            if (valor < 0 || valor > 255) {
+                cout << "Error: " << archivosEnmascaramiento[k] << " no es consistente con la máscara." << endl;
+                ok = false;
+            }
+            anterior[i] = (unsigned char)valor;
+            posterior[i] = imagenFinal[inicio + i];
+            conocidos[i] = 0xFF;
+        }
+        cerrarVistaEnmascaramiento(vista);
+
+        // Proyección de I_D hasta la imagen después del paso k + 1 (solo dentro de la ventana)
+        for (int j = n_archivos - 1; j > k && ok; --j) {
+            for (size_t i = 0; i < n; ++i) {
+                deshacerPaso(pasos[j], posterior[i], conocidos[i], imagenXOR[inicio + i]);
+            }
+        }
+
+        if (ok) {
+            int sobrevivientes = 0;
+            int c = identificarPaso(anterior, posterior, conocidos, imagenXOR + inicio, n, sobrevivientes);
+            if (c < 0) {
+                cout << "Error: ninguna operación explica el paso " << k + 1 << "." << endl;
+                ok = false;
+            } else {
+                pasos[k] = candidatoInferencia(c);
+                cout << "Paso " << k + 1 << ": " << describirOperacion(pasos[k]);
+                if (pasos[k].tipo != OP_XOR_IMAGEN) cout << " de " << pasos[k].parametro << " bits";
+                if (sobrevivientes > 1) cout << " (cumplen " << sobrevivientes << " candidatos; se elige el primero)";
+                cout << endl;
+            }
+        }
+        delete[] anterior;
+        delete[] posterior;
+        delete[] conocidos;
+    }
+
+    // Inversa completa: del último paso al primero
+    for (int k = n_archivos - 1; k >= 0 && ok; --k) {
+        const OperacionByte &op = pasos[k];
+        switch (op.tipo) {
+        case OP_XOR_IMAGEN:    ok = agregarOperacion(inversa, OP_XOR_IMAGEN, 0, imagenXOR); break;
+        case OP_XOR_CONSTANTE: ok = agregarOperacion(inversa, OP_XOR_CONSTANTE, op.parametro); break;
+        case OP_ROTAR_IZQ:     ok = agregarOperacion(inversa, OP_ROTAR_DER, op.parametro); break;
+        case OP_ROTAR_DER:     ok = agregarOperacion(inversa, OP_ROTAR_IZQ, op.parametro); break;
+        case OP_DESPLAZAR_IZQ: ok = agregarOperacion(inversa, OP_DESPLAZAR_DER, op.parametro); break;
+        case OP_DESPLAZAR_DER: ok = agregarOperacion(inversa, OP_DESPLAZAR_IZQ, op.parametro); break;
+        }
+    }
+
+    delete[] pasos;
+    return ok;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Microbenchmark de kernels
+// ---------------------------------------------------------------------------------------------
+
+enum TipoKernelBenchmark {
+    BENCH_XOR,
+    BENCH_ROTAR,
+    BENCH_SUMA_MASCARA
+};
+
+// Una variante: un kernel concreto (escalar o SIMD, un solo hilo) o la función pública, que elige
+// el mejor kernel y reparte el trabajo en el pool de hilos
+struct VarianteBenchmark {
+    TipoKernelBenchmark tipo;
+    const char* kernel;
+    const char* variante;
+    bool disponible;
+    bool paralela;
+    KernelXOR xorKernel;
+    KernelRotacion rotarKernel;
+};
+
+struct BuffersBenchmark {
+    unsigned char* a;
+    unsigned char* b;
+    unsigned char* salida;
+    unsigned short* suma;
+};
+
+static bool soportaCPU(const char* isa1, const char* isa2) {
+#ifdef DESAFIO_X86
+    __builtin_cpu_init();
+    // __builtin_cpu_supports solo acepta literales, así que se comparan los nombres usados abajo
+    bool ok = true;
+    const char* isas[2] = {isa1, isa2};
+    for (int k = 0; k < 2; ++k) {
+        const char* isa = isas[k];
+        if (isa == nullptr) continue;
+        if (strcmp(isa, "sse2") == 0) ok = ok && __builtin_cpu_supports("sse2");
+        else if (strcmp(isa, "avx2") == 0) ok = ok && __builtin_cpu_supports("avx2");
+        else if (strcmp(isa, "avx512bw") == 0) ok = ok && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+        else if (strcmp(isa, "gfni") == 0) ok = ok && __builtin_cpu_supports("gfni");
+        else ok = false;
+    }
+    return ok;
+#else
+    return isa1 == nullptr && isa2 == nullptr;
+#endif
+}
+
+static int listarVariantesBenchmark(VarianteBenchmark* v) {
+    int n = 0;
+    v[n++] = {BENCH_XOR, "xor", "escalar", true, false, applyXOR_Escalar, nullptr};
+#ifdef DESAFIO_X86
+    v[n++] = {BENCH_XOR, "xor", "sse2", soportaCPU("sse2", nullptr), false, applyXOR_SSE2, nullptr};
+    v[n++] = {BENCH_XOR, "xor", "avx2", soportaCPU("avx2", nullptr), false, applyXOR_AVX2, nullptr};
+    v[n++] = {BENCH_XOR, "xor", "avx512", soportaCPU("avx512bw", nullptr), false, applyXOR_AVX512, nullptr};
+#endif
+    v[n++] = {BENCH_XOR, "xor", "hilos", true, true, nullptr, nullptr};
+
+    v[n++] = {BENCH_ROTAR, "rotar", "escalar", true, false, nullptr, rotarIzquierda_Escalar};
+#ifdef DESAFIO_X86
+    v[n++] = {BENCH_ROTAR, "rotar", "sse2", soportaCPU("sse2", nullptr), false, nullptr, rotarIzquierda_SSE2};
+    v[n++] = {BENCH_ROTAR, "rotar", "avx2", soportaCPU("avx2", nullptr), false, nullptr, rotarIzquierda_AVX2};
+    v[n++] = {BENCH_ROTAR, "rotar", "gfni", soportaCPU("gfni", "avx2"), false, nullptr, rotarIzquierda_GFNI};
+#endif
+    v[n++] = {BENCH_ROTAR, "rotar", "hilos", true, true, nullptr, nullptr};
+
+    v[n++] = {BENCH_SUMA_MASCARA, "suma-mascara", "escalar", true, false, nullptr, nullptr};
+    v[n++] = {BENCH_SUMA_MASCARA, "suma-mascara", "hilos", true, true, nullptr, nullptr};
+    return n;
+}
+
+static void ejecutarVarianteBenchmark(const VarianteBenchmark &v, const BuffersBenchmark &buf, size_t n) {
+    switch (v.tipo) {
+    case BENCH_XOR:
+        if (v.paralela) applyXOR(buf.a, buf.b, buf.salida, n);
+        else v.xorKernel(buf.a, buf.b, buf.salida, n);
+        break;
+    case BENCH_ROTAR:
+        // En el mismo lugar, como rotateBitsRight
+        if (v.paralela) rotateBitsRight(buf.salida, n, 3);
+        else v.rotarKernel(buf.salida, buf.salida, n, 5);
+        break;
+    case BENCH_SUMA_MASCARA: {
+        ContextoSumaMascara contexto = {buf.a, buf.b, buf.suma};
+        if (v.paralela) ejecutarEnParalelo(tareaSumaMascara, &contexto, n);
+        else tareaSumaMascara(&contexto, 0, n);
+        break;
+    }
+    }
+}
+
+static inline unsigned long long leerContadorCiclos() {
+#ifdef DESAFIO_X86
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void ordenarMuestras(double* v, int n) {
+    for (int i = 1; i < n; ++i) {
+        double x = v[i];
+        int j = i - 1;
+        while (j >= 0 && v[j] > x) {
+            v[j + 1] = v[j];
+            --j;
+        }
+        v[j + 1] = x;
+    }
+}
+
+// Memoria física total en bytes (0 si no se puede averiguar)
+static unsigned long long memoriaFisica() {
+#ifdef _WIN32
+    MEMORYSTATUSEX estado;
+    estado.dwLength = sizeof(estado);
+    return GlobalMemoryStatusEx(&estado) ? estado.ullTotalPhys : 0;
+#else
+    long paginas = sysconf(_SC_PHYS_PAGES);
+    long tamanoPagina = sysconf(_SC_PAGE_SIZE);
+    if (paginas <= 0 || tamanoPagina <= 0) return 0;
+    return (unsigned long long)paginas * (unsigned long long)tamanoPagina;
+#endif
+}
+
+// Cada muestra repite el kernel hasta durar al menos MIN_NS_MUESTRA_BENCHMARK; se informa la mediana
+// de N_MUESTRAS_BENCHMARK muestras y la dispersión entre los cuartiles, después de una muestra de
+// calentamiento que también fija las repeticiones
+const int N_MUESTRAS_BENCHMARK = 7;
+const double MIN_NS_MUESTRA_BENCHMARK = 20e6;
+
+bool ejecutarBenchmarkKernels(size_t maxBytes) {
+    /*
+ * @brief Mide cada kernel (escalar, cada variante SIMD disponible y la versión con hilos) sobre
+ *        buffers desde 32 KiB (L1) hasta maxBytes, multiplicando el tamaño por 8 en cada paso.
+ *
+ * Imprime por cada combinación ns/byte, GB/s y ciclos/byte (del contador de tiempo de la CPU, que en
+ * las CPU actuales avanza a frecuencia nominal), todos de la mediana de las muestras, más la
+ * dispersión entre cuartiles en porcentaje de la mediana.
+ *
+ * Cada tamaño necesita 5 bytes por byte medido (a, b, salida y la suma de 16 bits), así que maxBytes
+ * se limita a que eso no pase de la mitad de la memoria física: con la sobreasignación de memoria
+ * de Linux una reserva demasiado grande no falla, sino que termina con el proceso al tocarla.
+ *
+ * @return false si no se pudo reservar ni el buffer más chico.
+ */
+    VarianteBenchmark variantes[16];
+    int n_variantes = listarVariantesBenchmark(variantes);
+
+    unsigned long long fisica = memoriaFisica();
+    if (fisica > 0 && maxBytes > fisica / 10) {
+        maxBytes = (size_t)(fisica / 10);
+        printf("Buffers limitados a %zu bytes (la mitad de la memoria física, repartida en 5 buffers).\n", maxBytes);
+    }
+
+    printf("%-13s %-8s %10s %9s %8s %12s %7s\n", "kernel", "variante", "bytes", "ns/byte", "GB/s", "ciclos/byte", "+-%");
+    bool algunTamano = false;
+    for (size_t n = 32 * 1024; n <= maxBytes; n *= 8) {
+        BuffersBenchmark buf = {nullptr, nullptr, nullptr, nullptr};
+        try {
+            buf.a = reservarBufferPixeles(n);
+            buf.b = reservarBufferPixeles(n);
+            buf.salida = reservarBufferPixeles(n);
+            buf.suma = (unsigned short*)reservarBufferPixeles(n * sizeof(unsigned short));
+        } catch (const bad_alloc &) {
+            printf("No hay memoria para buffers de %zu bytes; se detiene el benchmark.\n", n);
+            liberarBufferPixeles(buf.a);
+            liberarBufferPixeles(buf.b);
+            liberarBufferPixeles(buf.salida);
+            vaciarPoolBuffers();
+            break;
+        }
+        algunTamano = true;
+        // Contenido fijo y distinto de cero, y todas las páginas tocadas antes de medir
+        for (size_t i = 0; i < n; ++i) {
+            buf.a[i] = (unsigned char)(i * 131 + 7);
+            buf.b[i] = (unsigned char)(i * 197 + 3);
+            buf.salida[i] = (unsigned char)i;
+            buf.suma[i] = 0;
+        }
+
+        for (int k = 0; k < n_variantes; ++k) {
+            const VarianteBenchmark &v = variantes[k];
+            if (!v.disponible) continue;
+
+            // Calentamiento y calibración de las repeticiones por muestra
+            chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+            ejecutarVarianteBenchmark(v, buf, n);
+            double nsUna = (double)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+            long long repeticiones = nsUna > 0 ? (long long)(MIN_NS_MUESTRA_BENCHMARK / nsUna) + 1 : 1000;
+
+            double nsPorByte[N_MUESTRAS_BENCHMARK];
+            double ciclosPorByte[N_MUESTRAS_BENCHMARK];
+            for (int m = 0; m < N_MUESTRAS_BENCHMARK; ++m) {
+                unsigned long long c0 = leerContadorCiclos();
+                t0 = chrono::steady_clock::now();
+                for (long long r = 0; r < repeticiones; ++r) ejecutarVarianteBenchmark(v, buf, n);
+                double ns = (double)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+                unsigned long long ciclos = leerContadorCiclos() - c0;
+                double bytes = (double)n * (double)repeticiones;
+                nsPorByte[m] = ns / bytes;
+                ciclosPorByte[m] = (double)ciclos / bytes;
+            }
+            ordenarMuestras(nsPorByte, N_MUESTRAS_BENCHMARK);
+            ordenarMuestras(ciclosPorByte, N_MUESTRAS_BENCHMARK);
+            double mediana = nsPorByte[N_MUESTRAS_BENCHMARK / 2];
+            double dispersion = (nsPorByte[3 * N_MUESTRAS_BENCHMARK / 4] - nsPorByte[N_MUESTRAS_BENCHMARK / 4]) / mediana * 100.0;
+
+            printf("%-13s %-8s %10zu %9.4f %8.2f ", v.kernel, v.variante, n, mediana, 1.0 / mediana);
+#ifdef DESAFIO_X86
+            printf("%12.4f", ciclosPorByte[N_MUESTRAS_BENCHMARK / 2]);
+#else
+            printf("%12s", "-");
+#endif
+            printf(" %7.1f\n", dispersion);
+        }
+
+        // Los buffers de este tamaño no se vuelven a usar: se devuelven al sistema en lugar de dejarlos
+        // en el pool mientras se reservan los del tamaño siguiente
+        liberarBufferPixeles(buf.a);
+        liberarBufferPixeles(buf.b);
+        liberarBufferPixeles(buf.salida);
+        liberarBufferPixeles((unsigned char*)buf.suma);
+        vaciarPoolBuffers();
+        if (n > maxBytes / 8) break;
+    }
+    return algunTamano;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Casos sintéticos y benchmark de punta a punta
+// ---------------------------------------------------------------------------------------------
+
+// Generador pseudoaleatorio splitmix64: determinista, sin estado global y con buena calidad para
+// generar datos de prueba
+static inline unsigned long long siguienteAleatorio(unsigned long long &estado) {
+    unsigned long long z = (estado += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline unsigned char byteAleatorio(unsigned long long &estado) {
+    return (unsigned char)(siguienteAleatorio(estado) >> 56);
+}
+
+// Ruido de valor: una grilla de valores aleatorios cada 'celda' píxeles, interpolada bilinealmente
+struct RuidoDeValor {
+    int celda;
+    int gx;
+    int* grilla;
+};
+
+static void iniciarRuidoDeValor(RuidoDeValor &ruido, int width, int height, int celda, int amplitud,
+                                unsigned long long &estado) {
+    ruido.celda = celda;
+    ruido.gx = width / celda + 2;
+    size_t n = (size_t)ruido.gx * (height / celda + 2) * 3;
+    ruido.grilla = new int[n];
+    for (size_t i = 0; i < n; ++i) ruido.grilla[i] = (int)(siguienteAleatorio(estado) % (unsigned)(amplitud + 1));
+}
+
+// Suma a fila (width * 3 valores) el ruido de la fila y
+static void sumarFilaRuidoDeValor(const RuidoDeValor &ruido, int y, int width, int* fila) {
+    int celda = ruido.celda;
+    int cy = y / celda;
+    int fy = y % celda;
+    const int* arribaGrilla = ruido.grilla + (size_t)cy * ruido.gx * 3;
+    const int* abajoGrilla = arribaGrilla + (size_t)ruido.gx * 3;
+    for (int x = 0; x < width; ++x) {
+        int cx = x / celda;
+        int fx = x % celda;
+        for (int c = 0; c < 3; ++c) {
+            int v00 = arribaGrilla[(size_t)cx * 3 + c];
+            int v10 = arribaGrilla[((size_t)cx + 1) * 3 + c];
+            int v01 = abajoGrilla[(size_t)cx * 3 + c];
+            int v11 = abajoGrilla[((size_t)cx + 1) * 3 + c];
+            int arriba = v00 * (celda - fx) + v10 * fx;
+            int abajo = v01 * (celda - fx) + v11 * fx;
+            fila[(size_t)x * 3 + c] += (arriba * (celda - fy) + abajo * fy) / (celda * celda);
+        }
+    }
+}
+
+unsigned char* generarImagenSintetica(TipoImagenSintetica tipo, int width, int height, unsigned long long semilla) {
+    /*
+ * @brief Genera una imagen RGB determinista (la misma semilla da siempre los mismos bytes).
+ *
+ * - IMAGEN_ALEATORIA: bytes uniformes, el peor caso para cualquier compresión o predicción.
+ * - IMAGEN_DEGRADADO: degradados horizontales y verticales suaves.
+ * - IMAGEN_NATURAL: ruido de valor en dos escalas más un grano fino, con zonas suaves y bordes
+ *   como en una fotografía.
+ *
+ * @return Arreglo de width * height * 3 bytes (liberar con liberarBufferPixeles()), o nullptr si las dimensiones
+ *         no son válidas.
+ */
+    SpanTraza traza("generarImagenSintetica");
+    size_t dataSize = 0;
+    if (!tamanoImagenRGB(width, height, dataSize)) return nullptr;
+    traza.bytes = dataSize;
+    unsigned long long estado = semilla;
+    unsigned char* pixeles = reservarBufferPixeles(dataSize);
+
+    if (tipo == IMAGEN_ALEATORIA) {
+        size_t i = 0;
+        for (; i + 8 <= dataSize; i += 8) {
+            unsigned long long v = siguienteAleatorio(estado);
+            memcpy(pixeles + i, &v, 8);
+        }
+        for (; i < dataSize; ++i) pixeles[i] = byteAleatorio(estado);
+    } else if (tipo == IMAGEN_DEGRADADO) {
+        int fase = (int)(siguienteAleatorio(estado) & 0xFF);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                unsigned char* p = pixeles + ((size_t)y * width + x) * 3;
+                p[0] = (unsigned char)((long long)x * 255 / width + fase);
+                p[1] = (unsigned char)((long long)y * 255 / height);
+                p[2] = (unsigned char)(((long long)x + y) * 255 / ((long long)width + height) + fase / 2);
+            }
+        }
+    } else {
+        RuidoDeValor grueso, fino;
+        iniciarRuidoDeValor(grueso, width, height, 64, 160, estado);
+        iniciarRuidoDeValor(fino, width, height, 8, 80, estado);
+        // Se acumula de a una fila, no en un arreglo de int del tamaño de la imagen (4 bytes por byte)
+        size_t bytesFila = (size_t)width * 3;
+        int* fila = new int[bytesFila];
+        for (int y = 0; y < height; ++y) {
+            memset(fila, 0, bytesFila * sizeof(int));
+            sumarFilaRuidoDeValor(grueso, y, width, fila);
+            sumarFilaRuidoDeValor(fino, y, width, fila);
+            unsigned char* destino = pixeles + (size_t)y * bytesFila;
+            for (size_t i = 0; i < bytesFila; ++i) {
+                int v = fila[i] + (int)(siguienteAleatorio(estado) & 15) - 8;
+                destino[i] = (unsigned char)(v < 0 ? 0 : (v > 255 ? 255 : v));
+            }
+        }
+        delete[] fila;
+        delete[] grueso.grilla;
+        delete[] fino.grilla;
+    }
+    return pixeles;
+}
+
+// Cadena aleatoria de n_ops pasos sin pérdida (XOR con imagenXOR o rotaciones), para que la inversa
+// reconstruya la imagen exacta. No se compila.
+void generarCadenaAleatoria(CadenaTransformaciones &cadena, int n_ops, const unsigned char* imagenXOR,
+                            unsigned long long semilla) {
+    unsigned long long estado = semilla;
+    iniciarCadena(cadena);
+    for (int k = 0; k < n_ops; ++k) {
+        unsigned long long r = siguienteAleatorio(estado);
+        if (r % 3 == 0) {
+            agregarOperacion(cadena, OP_XOR_IMAGEN, 0, imagenXOR);
+        } else {
+            agregarOperacion(cadena, (r % 3 == 1) ? OP_ROTAR_IZQ : OP_ROTAR_DER, 1 + (int)((r >> 8) % 7));
+        }
+    }
+}
+
+static bool compararBuffers(const unsigned char* a, const unsigned char* b, size_t n);
+
+static double milisegundosDesde(chrono::steady_clock::time_point inicio) {
+    return (double)chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - inicio).count() / 1000.0;
+}
+
+// Aplica un solo paso de la cadena a toda la imagen, en el mismo lugar
+static void aplicarPasoImagen(const OperacionByte &op, unsigned char* datos, const unsigned char* imagenXOR,
+                              size_t dataSize) {
+    switch (op.tipo) {
+    case OP_XOR_IMAGEN: applyXOR(datos, imagenXOR, datos, dataSize); break;
+    case OP_ROTAR_IZQ:  rotateBitsLeft(datos, dataSize, op.parametro); break;
+    case OP_ROTAR_DER:  rotateBitsRight(datos, dataSize, op.parametro); break;
+    default: {
+        CadenaTransformaciones paso;
+        iniciarCadena(paso);
+        agregarOperacion(paso, op.tipo, op.parametro);
+        compilarCadena(paso, dataSize);
+        aplicarCadena(paso, datos, datos, dataSize);
+        liberarCadena(paso);
+        break;
+    }
+    }
+}
+
+struct ResolucionBenchmark {
+    const char* nombre;
+    int width;
+    int height;
+};
+
+static const ResolucionBenchmark resolucionesBenchmark[] = {
+    {"VGA", 640, 480},
+    {"HD", 1280, 720},
+    {"FHD", 1920, 1080},
+    {"4K", 3840, 2160},
+    {"8K", 7680, 4320},
+    {"16K", 15360, 8640},
+};
+
+static const char* const nombresTipoBenchmark[] = {"aleatoria", "degradado", "natural"};
+const int ANCHO_MASCARA_BENCHMARK = 32;
+const int ALTO_MASCARA_BENCHMARK = 32;
+
+// Un caso del benchmark: la fila de la tabla queda en fila, también si el caso falla. n_archivos
+// cuenta los bench_M<k>.txt escritos; los archivos los borra quien llama.
+static bool medirCasoBenchmark(const ResolucionBenchmark &res, int tipo, unsigned long long &estado, int &n_archivos,
+                               char* fila, size_t tamanoFila) {
+    const int pixelesMascara = ANCHO_MASCARA_BENCHMARK * ALTO_MASCARA_BENCHMARK;
+    const size_t tamanoMascara = (size_t)pixelesMascara * 3;
+    size_t dataSize = (size_t)res.width * res.height * 3;
+    n_archivos = 0;
+    snprintf(fila, tamanoFila, "%-4s %-9s %5s %9s %11s %10s %9s %9s %9s %8s NO", res.nombre, nombresTipoBenchmark[tipo],
+             "-", "-", "-", "-", "-", "-", "-", "-");
+
+    // Caso sintético
+    {
+        Imagen io = Imagen::adoptar(generarImagenSintetica((TipoImagenSintetica)tipo, res.width, res.height,
+                                                           siguienteAleatorio(estado)), res.width, res.height);
+        Imagen im = Imagen::adoptar(generarImagenSintetica(IMAGEN_ALEATORIA, res.width, res.height,
+                                                           siguienteAleatorio(estado)), res.width, res.height);
+        Imagen m = Imagen::adoptar(generarImagenSintetica(IMAGEN_ALEATORIA, ANCHO_MASCARA_BENCHMARK,
+                                                          ALTO_MASCARA_BENCHMARK, siguienteAleatorio(estado)),
+                                   ANCHO_MASCARA_BENCHMARK, ALTO_MASCARA_BENCHMARK);
+        if (!exportarImagen(io, "bench_I_O.bmp") || !exportarImagen(im, "bench_I_M.bmp") ||
+            !exportarImagen(m, "bench_M.bmp")) {
+            return false;
+        }
+    }
+
+    // Cargar
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    Imagen io = cargarImagen("bench_I_O.bmp");
+    Imagen im = cargarImagen("bench_I_M.bmp");
+    Imagen m = cargarImagen("bench_M.bmp");
+    double msCargar = milisegundosDesde(t0);
+    if (io.vacia() || im.vacia() || m.vacia()) return false;
+    Imagen estadoImagen = io.clonar();
+    if (estadoImagen.vacia()) return false;
+
+    CadenaTransformaciones cadena;
+    int n_pasos = 3 + (int)(siguienteAleatorio(estado) % 4);
+    generarCadenaAleatoria(cadena, n_pasos, im.datos, siguienteAleatorio(estado));
+
+    // Transformar paso a paso, escribiendo antes de cada paso su archivo de enmascaramiento
+    char nombres[MAX_OPERACIONES_CADENA][32];
+    const char* archivos[MAX_OPERACIONES_CADENA];
+    double msTransformar = 0, msEnmascarar = 0;
+    bool ok = true;
+    for (int k = 0; k < n_pasos && ok; ++k) {
+        snprintf(nombres[k], sizeof(nombres[k]), "bench_M%d.txt", k);
+        archivos[k] = nombres[k];
+        n_archivos = k + 1;
+        int seed = (int)(siguienteAleatorio(estado) % (unsigned long long)((size_t)res.width * res.height - pixelesMascara));
+        t0 = chrono::steady_clock::now();
+        ok = generarArchivoEnmascaramiento(nombres[k], estadoImagen.datos, m.datos, seed, pixelesMascara);
+        msEnmascarar += milisegundosDesde(t0);
+        t0 = chrono::steady_clock::now();
+        aplicarPasoImagen(cadena.ops[k], estadoImagen.propio, im.datos, dataSize);
+        msTransformar += milisegundosDesde(t0);
+    }
+    if (!ok) {
+        liberarCadena(cadena);
+        return false;
+    }
+
+    // Inversa: inferir los pasos desde I_D y reconstruir I_O
+    t0 = chrono::steady_clock::now();
+    CadenaTransformaciones inversa;
+    Imagen reconstruida(res.width, res.height);
+    ok = !reconstruida.vacia() &&
+         inferirTransformaciones(estadoImagen.datos, im.datos, dataSize, m.datos, tamanoMascara, archivos,
+                                 n_pasos, inversa) &&
+         compilarCadena(inversa, dataSize);
+    if (ok) aplicarCadena(inversa, estadoImagen.datos, reconstruida.propio, dataSize);
+    double msInversa = milisegundosDesde(t0);
+
+    t0 = chrono::steady_clock::now();
+    ok = ok && compararBuffers(reconstruida.datos, io.datos, dataSize);
+    double msComparar = milisegundosDesde(t0);
+
+    double total = msCargar + msTransformar + msEnmascarar + msInversa + msComparar;
+    snprintf(fila, tamanoFila, "%-4s %-9s %5d %9.2f %11.2f %10.2f %9.2f %9.2f %9.2f %8.1f %s",
+             res.nombre, nombresTipoBenchmark[tipo], n_pasos,
+             msCargar, msTransformar, msEnmascarar, msInversa, msComparar, total,
+             (double)dataSize / 1e6 / (total / 1000.0), ok ? "si" : "NO");
+
+    liberarCadena(inversa);
+    liberarCadena(cadena);
+    return ok;
+}
+
+bool ejecutarBenchmarkPipeline(const char* resolucionMaxima, unsigned long long semilla) {
+    /*
+ * @brief Benchmark de punta a punta sobre casos sintéticos, de VGA hasta resolucionMaxima.
+ *
+ * Por cada resolución y tipo de imagen genera I_O, I_M (aleatoria), una máscara M aleatoria de
+ * 32x32 y una cadena aleatoria de 3 a 6 pasos, escribe los BMP y mide por separado:
+ *   cargar       loadPixels de I_O, I_M y M desde el disco
+ *   transformar  cada paso aplicado a la imagen completa
+ *   enmascarar   un archivo de enmascaramiento antes de cada paso
+ *   inversa      inferencia de los pasos, compilación de la inversa y aplicación sobre I_D
+ *   comparar     la imagen reconstruida contra I_O
+ * Todo es determinista a partir de la semilla. Los archivos de cada caso se borran al terminarlo, y
+ * la tabla se imprime completa aunque algún caso falle (su fila queda marcada con NO).
+ *
+ * @return false si algún caso falló o no reconstruyó I_O.
+ */
+    const int n_resoluciones = (int)(sizeof(resolucionesBenchmark) / sizeof(resolucionesBenchmark[0]));
+    int ultima = n_resoluciones - 1;
+    if (resolucionMaxima != nullptr) {
+        for (int r = 0; r < n_resoluciones; ++r) {
+            if (strcmp(resolucionesBenchmark[r].nombre, resolucionMaxima) == 0) ultima = r;
+        }
+    }
+    // Las funciones medidas imprimen sus propios mensajes; la tabla se arma aparte y se imprime al final
+    char filas[sizeof(resolucionesBenchmark) / sizeof(resolucionesBenchmark[0]) * 3][160];
+    int n_filas = 0;
+    bool ok = true;
+    unsigned long long estado = semilla;
+
+    for (int r = 0; r <= ultima; ++r) {
+        const ResolucionBenchmark &res = resolucionesBenchmark[r];
+        for (int t = 0; t < 3; ++t) {
+            int n_archivos = 0;
+            ok = medirCasoBenchmark(res, t, estado, n_archivos, filas[n_filas++], sizeof(filas[0])) && ok;
+            // Los archivos del caso se borran siempre, aunque el caso haya fallado a mitad de camino
+            remove("bench_I_O.bmp");
+            remove("bench_I_M.bmp");
+            remove("bench_M.bmp");
+            for (int k = 0; k < n_archivos; ++k) {
+                char nombre[32];
+                snprintf(nombre, sizeof(nombre), "bench_M%d.txt", k);
+                remove(nombre);
+            }
+        }
+    }
+
+    printf("\n%-4s %-9s %5s %9s %11s %10s %9s %9s %9s %8s %s\n", "res", "imagen", "pasos", "cargar", "transformar",
+           "enmascarar", "inversa", "comparar", "total ms", "MB/s", "ok");
+    for (int f = 0; f < n_filas; ++f) printf("%s\n", filas[f]);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Verificación de la inferencia
+// ---------------------------------------------------------------------------------------------
+
+// Candidato c aplicado a un byte, escrito de nuevo a partir del orden documentado en
+// candidatoInferencia (0: XOR con I_M, 1..7: rotación a la derecha, 8..14: desplazamiento a la
+// izquierda, 15..21: desplazamiento a la derecha), sin compartir código con los kernels
+static unsigned char pasoReferencia(int c, unsigned char x, unsigned char xorImagen) {
+    if (c == 0) return x ^ xorImagen;
+    if (c <= 7) return (unsigned char)((x >> c) | (x << (8 - c)));
+    if (c <= 14) return (unsigned char)(x << (c - 7));
+    return (unsigned char)(x >> (c - 14));
+}
+
+// Referencia por fuerza bruta: cada candidato por separado y toda la ventana, sin máscara de vivos
+// compartida ni salida temprana
+static unsigned int referenciaCandidatos(const unsigned char* anterior, const unsigned char* posterior,
+                                         const unsigned char* conocidos, const unsigned char* xorImagen,
+                                         size_t n, unsigned int vivos) {
+    unsigned int resultado = 0;
+    for (int c = 0; c < N_CANDIDATOS_INFERENCIA; ++c) {
+        if ((vivos & (1u << c)) == 0) continue;
+        bool cumple = true;
+        for (size_t i = 0; i < n; ++i) {
+            if ((pasoReferencia(c, anterior[i], xorImagen[i]) ^ posterior[i]) & conocidos[i]) cumple = false;
+        }
+        if (cumple) resultado |= 1u << c;
+    }
+    return resultado;
+}
+
+struct KernelCandidatosVerificado {
+    const char* nombre;
+    bool disponible;
+    KernelCandidatos kernel;
+};
+
+bool verificarInferencia(int rondas, unsigned long long semilla) {
+    /*
+ * @brief Compara cada kernel de candidatos disponible (escalar, SSE2, AVX2) con referenciaCandidatos.
+ *
+ * Primero, de forma exhaustiva: para cada candidato, una ventana con los 65536 pares (byte, byte de
+ * I_M) cuya imagen posterior es ese candidato aplicado a cada par; el kernel tiene que dejar vivos
+ * exactamente los mismos candidatos que la referencia. Después, rondas ventanas aleatorias de largo
+ * variable (para ejercitar los restos escalares), con bits conocidos parciales como los que dejan
+ * los desplazamientos, conjuntos iniciales de vivos al azar y a veces un bit alterado.
+ *
+ * @return true si ningún kernel difiere de la referencia.
+ */
+    KernelCandidatosVerificado kernels[3];
+    int n_kernels = 0;
+    kernels[n_kernels++] = {"escalar", true, probarCandidatos_Escalar};
+#ifdef DESAFIO_X86
+    kernels[n_kernels++] = {"sse2", soportaCPU("sse2", nullptr), probarCandidatos_SSE2};
+    kernels[n_kernels++] = {"avx2", soportaCPU("avx2", nullptr), probarCandidatos_AVX2};
+#endif
+    const unsigned int todos = (1u << N_CANDIDATOS_INFERENCIA) - 1;
+    const size_t N_PARES = 256 * 256;
+    unsigned char* anterior = new unsigned char[N_PARES];
+    unsigned char* posterior = new unsigned char[N_PARES];
+    unsigned char* conocidos = new unsigned char[N_PARES];
+    unsigned char* xorImagen = new unsigned char[N_PARES];
+    long long discrepancias = 0;
+
+    // Todas las entradas posibles de un byte, para cada candidato
+    for (size_t i = 0; i < N_PARES; ++i) {
+        anterior[i] = (unsigned char)i;
+        xorImagen[i] = (unsigned char)(i >> 8);
+        conocidos[i] = 0xFF;
+    }
+    for (int c = 0; c < N_CANDIDATOS_INFERENCIA; ++c) {
+        for (size_t i = 0; i < N_PARES; ++i) posterior[i] = pasoReferencia(c, anterior[i], xorImagen[i]);
+        unsigned int esperado = referenciaCandidatos(anterior, posterior, conocidos, xorImagen, N_PARES, todos);
+        for (int k = 0; k < n_kernels; ++k) {
+            if (!kernels[k].disponible) continue;
+            unsigned int obtenido = kernels[k].kernel(anterior, posterior, conocidos, xorImagen, N_PARES, todos);
+            if (obtenido != esperado) {
+                if (discrepancias++ < 10) {
+                    printf("Kernel %s, candidato %d (todos los bytes): vivos %06x, referencia %06x\n",
+                           kernels[k].nombre, c, obtenido, esperado);
+                }
+            }
+        }
+    }
+
+    // Ventanas aleatorias
+    unsigned long long estado = semilla;
+    for (int r = 0; r < rondas; ++r) {
+        size_t n = (r % 16 == 0) ? (size_t)(siguienteAleatorio(estado) % 4096) : (size_t)(siguienteAleatorio(estado) % 200);
+        int verdadero = (int)(siguienteAleatorio(estado) % N_CANDIDATOS_INFERENCIA);
+        int tipoConocidos = (int)(siguienteAleatorio(estado) % 3);
+        int corrimiento = 1 + (int)(siguienteAleatorio(estado) % 7);
+        for (size_t i = 0; i < n; ++i) {
+            anterior[i] = byteAleatorio(estado);
+            xorImagen[i] = byteAleatorio(estado);
+            posterior[i] = pasoReferencia(verdadero, anterior[i], xorImagen[i]);
+            if (tipoConocidos == 0) conocidos[i] = 0xFF;
+            else if (tipoConocidos == 1) conocidos[i] = (unsigned char)(0xFF << corrimiento);
+            else conocidos[i] = byteAleatorio(estado);
+        }
+        if (n > 0 && siguienteAleatorio(estado) % 2 == 0) {
+            posterior[siguienteAleatorio(estado) % n] ^= (unsigned char)(1 << (siguienteAleatorio(estado) % 8));
+        }
+        unsigned int vivos = (siguienteAleatorio(estado) % 4 == 0) ? (unsigned int)siguienteAleatorio(estado) & todos : todos;
+
+        unsigned int esperado = referenciaCandidatos(anterior, posterior, conocidos, xorImagen, n, vivos);
+        for (int k = 0; k < n_kernels; ++k) {
+            if (!kernels[k].disponible) continue;
+            unsigned int obtenido = kernels[k].kernel(anterior, posterior, conocidos, xorImagen, n, vivos);
+            if (obtenido != esperado) {
+                if (discrepancias++ < 10) {
+                    printf("Kernel %s, ventana %d (%zu bytes): vivos %06x, referencia %06x\n",
+                           kernels[k].nombre, r, n, obtenido, esperado);
+                }
+            }
+        }
+    }
+
+    delete[] anterior;
+    delete[] posterior;
+    delete[] conocidos;
+    delete[] xorImagen;
+
+    printf("Kernels verificados:");
+    for (int k = 0; k < n_kernels; ++k) {
+        if (kernels[k].disponible) printf(" %s", kernels[k].nombre);
+    }
+    printf("\n%d candidatos x 65536 pares de bytes y %d ventanas aleatorias: %lld discrepancias.\n",
+           N_CANDIDATOS_INFERENCIA, rondas, discrepancias);
+    return discrepancias == 0;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Pipeline perezoso
+// ---------------------------------------------------------------------------------------------
+
+struct ContextoComparacion {
+    const unsigned char* a;
+    const unsigned char* b;
+    atomic<bool> distintos;
+};
+
+// Cada hilo compara su rango por tramos, para enterarse pronto si otro ya encontró una diferencia
+static void tareaComparacion(void* contexto, size_t desde, size_t hasta) {
+    ContextoComparacion* c = (ContextoComparacion*)contexto;
+    const size_t tramo = 1 << 16;
+    for (size_t i = desde; i < hasta && !c->distintos.load(memory_order_relaxed); i += tramo) {
+        size_t n = hasta - i < tramo ? hasta - i : tramo;
+        if (memcmp(c->a + i, c->b + i, n) != 0) c->distintos.store(true, memory_order_relaxed);
+    }
+}
+
+// memcmp repartido entre los hilos del pool
+static bool compararBuffers(const unsigned char* a, const unsigned char* b, size_t n) {
+    SpanTraza traza("compararBuffers", n * 2);
+    ContextoComparacion contexto;
+    contexto.a = a;
+    contexto.b = b;
+    contexto.distintos = false;
+    ejecutarEnParalelo(tareaComparacion, &contexto, n);
+    return !contexto.distintos.load();
+}
+
+void iniciarPipeline(Pipeline &pipeline) {
+    pipeline.n_etapas = 0;
+    pipeline.n_sumideros = 0;
+    pipeline.n_sumiderosLanzados = 0;
+}
+
+static int nuevaEtapa(Pipeline &pipeline, TipoEtapa tipo) {
+    if (pipeline.n_etapas >= MAX_ETAPAS_PIPELINE) {
+        cout << "Error: el pipeline tiene demasiadas etapas." << endl;
+        return -1;
+    }
+    EtapaPipeline &etapa = pipeline.etapas[pipeline.n_etapas];
+    etapa.tipo = tipo;
+    etapa.entradas[0] = -1;
+    etapa.entradas[1] = -1;
+    etapa.parametro = 0;
+    etapa.ruta.clear();
+    etapa.consumidores = 0;
+    etapa.evaluada = false;
+    etapa.imagen = Imagen();
+    etapa.iguales = false;
+    return pipeline.n_etapas++;
+}
+
+static bool etapaValida(const Pipeline &pipeline, int etapa) {
+    return etapa >= 0 && etapa < pipeline.n_etapas;
+}
+
+int agregarCarga(Pipeline &pipeline, const char* ruta) {
+    int id = nuevaEtapa(pipeline, ETAPA_CARGAR);
+    if (id >= 0) pipeline.etapas[id].ruta = ruta;
+    return id;
+}
+
+int agregarEtapa(Pipeline &pipeline, TipoEtapa tipo, int entrada0, int entrada1, int parametro) {
+    bool binaria = (tipo == ETAPA_XOR || tipo == ETAPA_INVERSA || tipo == ETAPA_COMPARAR);
+    if (tipo == ETAPA_CARGAR || !etapaValida(pipeline, entrada0) || (binaria && !etapaValida(pipeline, entrada1))) {
+        cout << "Error: etapa del pipeline con entradas inválidas." << endl;
+        return -1;
+    }
+    int id = nuevaEtapa(pipeline, tipo);
+    if (id < 0) return -1;
+    EtapaPipeline &etapa = pipeline.etapas[id];
+    etapa.entradas[0] = entrada0;
+    etapa.entradas[1] = binaria ? entrada1 : -1;
+    etapa.parametro = parametro;
+    pipeline.etapas[entrada0].consumidores++;
+    if (binaria) pipeline.etapas[entrada1].consumidores++;
+    return id;
+}
+
+static SumideroPipeline* nuevoSumidero(Pipeline &pipeline, TipoSumidero tipo, int etapa, const char* ruta) {
+    if (pipeline.n_sumideros >= MAX_SUMIDEROS_PIPELINE || !etapaValida(pipeline, etapa) ||
+        pipeline.etapas[etapa].tipo == ETAPA_COMPARAR) {
+        cout << "Error: no se pudo agregar la salida " << ruta << " al pipeline." << endl;
+        return nullptr;
+    }
+    SumideroPipeline &sumidero = pipeline.sumideros[pipeline.n_sumideros++];
+    sumidero.tipo = tipo;
+    sumidero.etapa = etapa;
+    sumidero.etapaMascara = -1;
+    sumidero.offset = 0;
+    sumidero.ruta = ruta;
+    sumidero.ok = false;
+    pipeline.etapas[etapa].consumidores++;
+    return &sumidero;
+}
+
+bool agregarExportacion(Pipeline &pipeline, int etapa, const char* ruta) {
+    return nuevoSumidero(pipeline, SUMIDERO_BMP, etapa, ruta) != nullptr;
+}
+
+bool agregarEnmascaramiento(Pipeline &pipeline, int etapa, int etapaMascara, int offset, const char* ruta,
+                            bool binario) {
+    if (!etapaValida(pipeline, etapaMascara)) return false;
+    SumideroPipeline* sumidero = nuevoSumidero(pipeline, binario ? SUMIDERO_ENMASCARAMIENTO_BINARIO : SUMIDERO_ENMASCARAMIENTO,
+                                               etapa, ruta);
+    if (sumidero == nullptr) return false;
+    sumidero->etapaMascara = etapaMascara;
+    sumidero->offset = offset;
+    pipeline.etapas[etapaMascara].consumidores++;
+    return true;
+}
+
+// Comprueba que las dos entradas de una etapa binaria tengan el mismo tamaño
+static bool mismasDimensiones(const EtapaPipeline &a, const EtapaPipeline &b) {
+    if (a.imagen.width != b.imagen.width || a.imagen.height != b.imagen.height) {
+        cout << "Error: las imágenes del pipeline no tienen el mismo tamaño." << endl;
+        return false;
+    }
+    return true;
+}
+
+// Nombres de las etapas y sumideros en las trazas (en el orden de TipoEtapa y TipoSumidero)
+static const char* const nombresEtapaTraza[] = {"etapa cargar", "etapa xor", "etapa rotar", "etapa inversa",
+                                                "etapa comparar"};
+static const char* const nombresSumideroTraza[] = {"sumidero bmp", "sumidero enmascaramiento",
+                                                   "sumidero enmascaramiento binario"};
+
+// Calcula juntos el XOR idXOR y la rotación a la derecha idRotacion que lo lee. El XOR solo se guarda
+// si se pidió directamente (guardarXOR) o si alguien más que la rotación lo necesita.
+static bool evaluarXORRotacion(Pipeline &pipeline, int idXOR, int idRotacion, bool guardarXOR) {
+    EtapaPipeline &previa = pipeline.etapas[idXOR];
+    EtapaPipeline &etapa = pipeline.etapas[idRotacion];
+    if (!evaluarEtapa(pipeline, previa.entradas[0]) || !evaluarEtapa(pipeline, previa.entradas[1])) return false;
+    const EtapaPipeline &a = pipeline.etapas[previa.entradas[0]];
+    const EtapaPipeline &b = pipeline.etapas[previa.entradas[1]];
+    if (!mismasDimensiones(a, b)) return false;
+
+    size_t dataSize = a.imagen.bytes();
+    SpanTraza traza(nombresEtapaTraza[etapa.tipo], dataSize);
+    unsigned char* intermedio = nullptr;
+    if (guardarXOR || previa.consumidores > 1) {
+        previa.imagen = Imagen(a.imagen.width, a.imagen.height);
+        if (previa.imagen.vacia()) return false;
+        intermedio = previa.imagen.propio;
+    }
+    etapa.imagen = Imagen(a.imagen.width, a.imagen.height);
+    if (etapa.imagen.vacia()) return false;
+    applyXORRotateRight(a.imagen.datos, b.imagen.datos, intermedio, etapa.imagen.propio, dataSize, -etapa.parametro);
+    previa.evaluada = intermedio != nullptr;
+    etapa.evaluada = true;
+    return true;
+}
+
+bool evaluarEtapa(Pipeline &pipeline, int id) {
+    if (!etapaValida(pipeline, id)) return false;
+    EtapaPipeline &etapa = pipeline.etapas[id];
+    if (etapa.evaluada) return true;
+
+    if (etapa.tipo == ETAPA_CARGAR) {
+        SpanTraza traza(nombresEtapaTraza[etapa.tipo]);
+        int width = 0, height = 0;
+        const unsigned char* datos = obtenerImagenCacheada(etapa.ruta.c_str(), width, height);
+        etapa.imagen = Imagen::vistaDe(datos, width, height);
+        traza.bytes = etapa.imagen.bytes();
+        etapa.evaluada = !etapa.imagen.vacia();
+        return etapa.evaluada;
+    }
+
+    // Un XOR sin calcular y una rotación a la derecha de ese XOR se hacen en una sola pasada, se pida
+    // primero cualquiera de las dos: al pedir la rotación se busca su XOR, y al pedir el XOR se busca
+    // una rotación pendiente que lo lea
+    if (etapa.tipo == ETAPA_ROTAR && etapa.parametro < 0) {
+        const EtapaPipeline &previa = pipeline.etapas[etapa.entradas[0]];
+        if (previa.tipo == ETAPA_XOR && !previa.evaluada) return evaluarXORRotacion(pipeline, etapa.entradas[0], id, false);
+    }
+    if (etapa.tipo == ETAPA_XOR) {
+        for (int k = 0; k < pipeline.n_etapas; ++k) {
+            const EtapaPipeline &rotacion = pipeline.etapas[k];
+            if (rotacion.tipo == ETAPA_ROTAR && rotacion.parametro < 0 && rotacion.entradas[0] == id &&
+                !rotacion.evaluada) {
+                return evaluarXORRotacion(pipeline, id, k, true);
+            }
+        }
+    }
+
+    if (!evaluarEtapa(pipeline, etapa.entradas[0])) return false;
+    if (etapa.entradas[1] >= 0 && !evaluarEtapa(pipeline, etapa.entradas[1])) return false;
+    EtapaPipeline &a = pipeline.etapas[etapa.entradas[0]];
+    if (etapa.entradas[1] >= 0 && !mismasDimensiones(a, pipeline.etapas[etapa.entradas[1]])) return false;
+    const unsigned char* datosA = a.imagen.datos;
+    const unsigned char* datosB = etapa.entradas[1] >= 0 ? pipeline.etapas[etapa.entradas[1]].imagen.datos : nullptr;
+
+    size_t dataSize = a.imagen.bytes();
+    SpanTraza traza(nombresEtapaTraza[etapa.tipo], dataSize);
+
+    if (etapa.tipo == ETAPA_COMPARAR) {
+        etapa.iguales = compararBuffers(datosA, datosB, dataSize);
+        etapa.evaluada = true;
+        return true;
+    }
+
+    // Si nadie más lee la entrada y es dueña de su buffer, la etapa se lo queda y trabaja en el mismo
+    // lugar (todos los kernels admiten destino igual a origen): ni reserva ni copia
+    if (a.consumidores == 1 && !a.imagen.esVista()) {
+        etapa.imagen = move(a.imagen);
+        a.evaluada = false;
+    } else {
+        etapa.imagen = Imagen(a.imagen.width, a.imagen.height);
+        if (etapa.imagen.vacia()) return false;
+    }
+    switch (etapa.tipo) {
+    case ETAPA_XOR:
+        applyXOR(datosA, datosB, etapa.imagen.propio, dataSize);
+        break;
+    case ETAPA_ROTAR:
+        if (etapa.parametro >= 0) {
+            rotarEnParalelo(datosA, etapa.imagen.propio, dataSize, etapa.parametro);
+        } else {
+            rotarEnParalelo(datosA, etapa.imagen.propio, dataSize, 8 - ((-etapa.parametro) & 7));
+        }
+        break;
+    case ETAPA_INVERSA:
+        applyRotateLeftXOR(datosA, datosB, etapa.imagen.propio, dataSize, etapa.parametro);
+        break;
+    default:
+        break;
+    }
+    etapa.evaluada = true;
+    return true;
+}
+
+// Cuerpo de los hilos de los sumideros: solo leen buffers ya evaluados
+static void ejecutarSumidero(const Pipeline* pipeline, SumideroPipeline* sumidero) {
+    const EtapaPipeline &etapa = pipeline->etapas[sumidero->etapa];
+    SpanTraza traza(nombresSumideroTraza[sumidero->tipo], etapa.imagen.bytes());
+    if (sumidero->tipo == SUMIDERO_BMP) {
+        sumidero->ok = exportarImagen(etapa.imagen, sumidero->ruta.c_str());
+        return;
+    }
+
+    const EtapaPipeline &mascara = pipeline->etapas[sumidero->etapaMascara];
+    size_t pixelesMascara = mascara.imagen.bytes() / 3;
+    size_t pixelesImagen = etapa.imagen.bytes() / 3;
+    if (pixelesMascara > (size_t)MAX_PIXELES_ENMASCARAMIENTO) {
+        cout << "Error: la máscara es demasiado grande para un archivo de enmascaramiento." << endl;
+        sumidero->ok = false;
+        return;
+    }
+    if (sumidero->offset < 0 || (size_t)sumidero->offset > pixelesImagen ||
+        pixelesMascara > pixelesImagen - (size_t)sumidero->offset) {
+        cout << "Error: la máscara no cabe en la imagen a partir de la semilla " << sumidero->offset << endl;
+        sumidero->ok = false;
+        return;
+    }
+    int n_pixels = (int)pixelesMascara;
+    if (sumidero->tipo == SUMIDERO_ENMASCARAMIENTO_BINARIO) {
+        sumidero->ok = generarArchivoEnmascaramientoBinario(sumidero->ruta.c_str(), etapa.imagen.datos,
+                                                            mascara.imagen.datos, sumidero->offset, n_pixels,
+                                                            mascara.imagen.width, mascara.imagen.height);
+    } else {
+        sumidero->ok = generarArchivoEnmascaramiento(sumidero->ruta.c_str(), etapa.imagen.datos, mascara.imagen.datos,
+                                                     sumidero->offset, n_pixels);
+    }
+    if (sumidero->ok) cout << sumidero->ruta << " generado correctamente." << endl;
+}
+
+// Evalúa lo que necesita cada sumidero pendiente y lo lanza en su propio hilo. No espera a que
+// terminen: eso lo hace liberarPipeline (o una nueva llamada tras agregar más sumideros).
+bool ejecutarPipeline(Pipeline &pipeline) {
+    bool ok = true;
+    for (; pipeline.n_sumiderosLanzados < pipeline.n_sumideros; ++pipeline.n_sumiderosLanzados) {
+        SumideroPipeline &sumidero = pipeline.sumideros[pipeline.n_sumiderosLanzados];
+        if (!evaluarEtapa(pipeline, sumidero.etapa) ||
+            (sumidero.etapaMascara >= 0 && !evaluarEtapa(pipeline, sumidero.etapaMascara))) {
+            cout << "Error: no se pudo calcular la entrada de " << sumidero.ruta << endl;
+            ok = false;
+            continue;
+        }
+        sumidero.hilo = thread(ejecutarSumidero, &pipeline, &sumidero);
+    }
+    return ok;
+}
+
+// Espera a que terminen los sumideros lanzados. Devuelve false si alguna escritura falló.
+bool esperarPipeline(Pipeline &pipeline) {
+    bool ok = true;
+    for (int i = 0; i < pipeline.n_sumiderosLanzados; ++i) {
+        SumideroPipeline &sumidero = pipeline.sumideros[i];
+        if (sumidero.hilo.joinable()) {
+            sumidero.hilo.join();
+            ok = ok && sumidero.ok;
+        }
+    }
+    return ok;
+}
+
+// Espera a los sumideros y libera los buffers propios de las etapas
+void liberarPipeline(Pipeline &pipeline) {
+    esperarPipeline(pipeline);
+    for (int i = 0; i < pipeline.n_etapas; ++i) {
+        pipeline.etapas[i].imagen = Imagen();
+        pipeline.etapas[i].evaluada = false;
+    }
+    pipeline.n_etapas = 0;
+    pipeline.n_sumideros = 0;
+    pipeline.n_sumiderosLanzados = 0;
+}